@@ -2,84 +2,263 @@
  * Implementación de Almacen.
  */
 #include "Almacen.hh"
+#include "Salida.hh"
 #ifndef NO_DIAGRAM
+#    include <algorithm> // std::stable_sort
+#    include <cassert>
+#    include <cstdio>  // std::rename
+#    include <cstring> // std::memcmp
+#    include <fcntl.h>
 #    include <list>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    include <utility> // std::pair, std::move
 #endif
 
+/// Cabecera de las instantáneas; el último carácter es la versión del formato.
+static const char CABECERA[8] = {'A', 'L', 'M', 'A', 'C', 'E', 'N', '2'};
+
 /*------------------+
- | Statics privados |
+ | Métodos privados |
  +------------------*/
 
-void Almacen::leer_estructura(istream &is, BinTree<int> &tree) {
-    int n;
-    is >> n;
-    if (n == 0) {
-        // Caso base: Árbol vacío
-        tree = BinTree<int>();
-        return;
+void Almacen::leer_estructura(Lector &lector) {
+    estructura_salas.clear();
+    // Nodos a los que les falta algún hijo por leer. Si el hijo izquierdo
+    // todavía no se ha leído, vale -2.
+    vector<int> pendientes;
+    do {
+        IdSala n;
+        lector.leer(n);
+        int nodo = -1; // Árbol vacío
+        if (n != 0) {
+            nodo = estructura_salas.size();
+            Nodo nuevo = {n, -2, -2, 1};
+            estructura_salas.push_back(nuevo);
+            preorden[n - 1] = nodo;
+        }
+        if (not pendientes.empty()) {
+            // El subárbol leído es un hijo del último nodo pendiente
+            Nodo &padre = estructura_salas[pendientes.back()];
+            if (padre.izquierdo == -2) {
+                padre.izquierdo = nodo;
+            } else {
+                padre.derecho = nodo;
+                pendientes.pop_back();
+            }
+        }
+        if (nodo != -1) pendientes.push_back(nodo);
+    } while (not pendientes.empty());
+
+    // Los hijos están después de su padre: recorriendo el vector al revés se
+    // calculan los tamaños de los subárboles antes de necesitarlos.
+    for (int nodo = int(estructura_salas.size()) - 1; nodo >= 0; --nodo) {
+        Nodo &n = estructura_salas[nodo];
+        if (n.izquierdo != -1) n.tam += estructura_salas[n.izquierdo].tam;
+        if (n.derecho != -1) n.tam += estructura_salas[n.derecho].tam;
     }
-    BinTree<int> left, right;
-    leer_estructura(is, left);
-    leer_estructura(is, right);
-    tree = BinTree<int>(n, left, right);
 }
 
-/*------------------+
- | Métodos privados |
- +------------------*/
+void Almacen::actualizar_libre(IdSala id_sala, int delta) {
+    for (int i = preorden[id_sala - 1] + 1; i < libre.size(); i += i & -i) {
+        libre[i] += delta;
+    }
+}
+
+int Almacen::libre_subarbol(int nodo) const {
+    // Suma de las posiciones [primero, ultimo] del preorden (desde 1)
+    int primero = nodo + 1;
+    int ultimo = primero + estructura_salas[nodo].tam - 1;
+    int suma = 0;
+    for (int i = ultimo; i > 0; i -= i & -i) suma += libre[i];
+    for (int i = primero - 1; i > 0; i -= i & -i) suma -= libre[i];
+    return suma;
+}
 
 Sala &Almacen::sala(IdSala id_sala) {
     assert(0 < id_sala and id_sala <= salas.size());
-    return salas[id_sala - 1];
+    if (sala_compartida[id_sala - 1]) {
+        salas[id_sala - 1] = make_shared<Sala>(*salas[id_sala - 1]);
+        sala_compartida[id_sala - 1] = false;
+    }
+    return *salas[id_sala - 1];
+}
+
+Catalogo &Almacen::catalogo_propio() {
+    if (catalogo_compartido) {
+        catalogo = make_shared<Catalogo>(*catalogo);
+        catalogo_compartido = false;
+    }
+    return *catalogo;
+}
+
+vector<int> &Almacen::productos_propios() {
+    if (productos_compartidos) {
+        productos = make_shared<vector<int> >(*productos);
+        productos_compartidos = false;
+    }
+    return *productos;
+}
+
+void Almacen::anotar_ubicacion(Producto producto, IdSala id_sala, int delta) {
+    if (delta == 0) return;
+    map<IdSala, int> &salas_producto = ubicaciones[producto];
+    int &cantidad = salas_producto[id_sala];
+    cantidad += delta;
+    assert(cantidad >= 0);
+    if (cantidad == 0) salas_producto.erase(id_sala);
 }
 
 const Sala &Almacen::sala(IdSala id_sala) const {
     assert(0 < id_sala and id_sala <= salas.size());
-    return salas[id_sala - 1];
+    return *salas[id_sala - 1];
 }
 
-int Almacen::i_distribuir(const BinTree<IdSala> &tree, IdProducto id_producto,
-                          int cantidad) {
-    if (tree.empty()) return cantidad; // Caso base
-    int sobran = sala(tree.value()).poner_items(id_producto, cantidad);
-    if (sobran == 0) return 0;
-    int cantidad_right = sobran / 2;
-    int cantidad_left = sobran - cantidad_right;
-    int sobran_right = i_distribuir(tree.right(), id_producto, cantidad_right);
-    int sobran_left = i_distribuir(tree.left(), id_producto, cantidad_left);
-    return sobran_right + sobran_left;
+int Almacen::i_distribuir(int nodo, Producto producto, int cantidad) {
+    int sobran_total = 0;
+    // Subárboles por visitar, con la cantidad que se les ha asignado
+    vector<pair<int, int> > pila(1, make_pair(nodo, cantidad));
+    while (not pila.empty()) {
+        nodo = pila.back().first;
+        cantidad = pila.back().second;
+        pila.pop_back();
+        if (nodo == -1 or libre_subarbol(nodo) == 0) {
+            // Árbol vacío o subárbol lleno: no cabe nada
+            sobran_total += cantidad;
+            continue;
+        }
+        const Nodo &n = estructura_salas[nodo];
+        int sobran = sala(n.id_sala).poner_items(producto, cantidad);
+        ++trabajo.salas_visitadas;
+        anotar_ubicacion(producto, n.id_sala, cantidad - sobran);
+        actualizar_libre(n.id_sala, sobran - cantidad);
+        if (sobran == 0) continue;
+        int cantidad_right = sobran / 2;
+        int cantidad_left = sobran - cantidad_right;
+        pila.push_back(make_pair(n.izquierdo, cantidad_left));
+        pila.push_back(make_pair(n.derecho, cantidad_right));
+    }
+    return sobran_total;
+}
+
+bool Almacen::leer_instantanea(LectorBinario &lector) {
+    char cabecera[sizeof CABECERA];
+    if (not lector.leer(cabecera, sizeof cabecera) or
+        memcmp(cabecera, CABECERA, sizeof CABECERA) != 0)
+        return false;
+
+    // Árbol: cada nodo debe tener sus hijos justo después, como en preorden
+    int n;
+    if (not lector.leer(n) or n <= 0 or n > lector.restantes() / sizeof(Nodo))
+        return false;
+    estructura_salas.resize(n);
+    if (not lector.leer(estructura_salas.data(), n)) return false;
+    preorden = vector<int>(n, -1);
+    for (int nodo = n - 1; nodo >= 0; --nodo) {
+        const Nodo &actual = estructura_salas[nodo];
+        if (actual.id_sala < 1 or actual.id_sala > n or
+            preorden[actual.id_sala - 1] != -1)
+            return false;
+        preorden[actual.id_sala - 1] = nodo;
+        int tam = 1, siguiente = nodo + 1;
+        if (actual.izquierdo != -1) {
+            if (actual.izquierdo != siguiente or siguiente >= n) return false;
+            tam += estructura_salas[siguiente].tam;
+            siguiente = nodo + tam;
+        }
+        if (actual.derecho != -1) {
+            if (actual.derecho != siguiente or siguiente >= n) return false;
+            tam += estructura_salas[siguiente].tam;
+        }
+        if (actual.tam != tam) return false;
+    }
+    if (estructura_salas[0].tam != n) return false;
+
+    if (not catalogo_propio().cargar(lector)) return false;
+    // El inventario global no se guarda: se recalcula con el de las salas
+    vector<int> &inventario_global = productos_propios();
+    inventario_global.assign(catalogo->max_codigo(), 0);
+
+    salas = vector<shared_ptr<Sala> >(n);
+    sala_compartida = vector<char>(n, false);
+    libre = vector<int>(n + 1, 0);
+    ubicaciones = vector<map<IdSala, int> >(inventario_global.size());
+    for (int i = 0; i < n; ++i) {
+        salas[i] = make_shared<Sala>();
+        if (not salas[i]->cargar(lector, *catalogo)) return false;
+        actualizar_libre(i + 1, salas[i]->espacio_libre());
+        const InventarioSala &inventario = salas[i]->consultar_inventario();
+        InventarioSala::const_iterator it;
+        for (it = inventario.begin(); it != inventario.end(); ++it) {
+            ubicaciones[it->first][i + 1] = it->second.size();
+            inventario_global[it->first] += it->second.size();
+        }
+    }
+    return lector.final();
 }
 
 /*---------------+
  | Constructores |
  +---------------*/
 
-Almacen::Almacen() {} // Constructor por defecto
+Almacen::Almacen()
+    : catalogo(make_shared<Catalogo>()), catalogo_compartido(false),
+      productos(make_shared<vector<int> >()), productos_compartidos(false),
+      trabajo() {}
+
+Almacen::Almacen(const Almacen &otro) : Almacen() {
+    *this = otro;
+}
+
+Almacen &Almacen::operator=(const Almacen &otro) {
+    if (this == &otro) return *this;
+    estructura_salas = otro.estructura_salas;
+    salas = vector<shared_ptr<Sala> >(otro.salas.size());
+    for (int i = 0; i < salas.size(); ++i) {
+        salas[i] = make_shared<Sala>(*otro.salas[i]);
+    }
+    sala_compartida = vector<char>(salas.size(), false);
+    preorden = otro.preorden;
+    libre = otro.libre;
+    catalogo = make_shared<Catalogo>(*otro.catalogo);
+    catalogo_compartido = false;
+    productos = make_shared<vector<int> >(*otro.productos);
+    productos_compartidos = false;
+    ubicaciones = otro.ubicaciones;
+    trabajo = otro.trabajo;
+    return *this;
+}
 
 /*------------------+
  | Métodos públicos |
  +------------------*/
 
 bool Almacen::poner_prod(IdProducto id_producto) {
-    return productos.insert({id_producto, 0}).second;
-    // Intenta insertar el producto (con 0 elementos).
-    // Si no existe, Inventario::insert lo crea y retorna un pair cuyo segundo
-    // elemento es true. Si ya existe, es false, y no modifica el inventario.
+    if (catalogo->codigo(id_producto) != NINGUN_PRODUCTO) return false;
+    Producto producto = catalogo_propio().alta(id_producto);
+    vector<int> &inventario_global = productos_propios();
+    if (producto >= inventario_global.size()) {
+        inventario_global.resize(producto + 1);
+        ubicaciones.resize(producto + 1);
+    }
+    inventario_global[producto] = 0;
+    return true;
 }
 
 bool Almacen::quitar_prod(IdProducto id_producto) {
-    Inventario::iterator it;
-    it = productos.find(id_producto);
-    if (it == productos.end() or it->second > 0) return false;
-    productos.erase(it);
+    Producto producto = catalogo->codigo(id_producto);
+    if (producto == NINGUN_PRODUCTO or (*productos)[producto] > 0) return false;
+    catalogo_propio().baja(producto);
     return true;
 }
 
 int Almacen::distribuir(IdProducto id_producto, int cantidad) {
-    Inventario::iterator it = productos.find(id_producto);
-    if (it == productos.end()) return -1; // El producto no existe
-    int sobran = i_distribuir(estructura_salas, id_producto, cantidad);
-    it->second += cantidad - sobran;
+    Producto producto = catalogo->codigo(id_producto);
+    if (producto == NINGUN_PRODUCTO) return -1; // El producto no existe
+    int sobran = i_distribuir(0, producto, cantidad);
+    productos_propios()[producto] += cantidad - sobran;
+    trabajo.posiciones_ocupadas += cantidad - sobran;
     return sobran;
 }
 
@@ -92,10 +271,40 @@ int Almacen::num_salas() const {
 }
 
 int Almacen::consultar_prod(IdProducto id_producto) const {
-    Inventario::const_iterator it;
-    it = productos.find(id_producto);
-    if (it == productos.end()) return -1;
-    return it->second;
+    Producto producto = catalogo->codigo(id_producto);
+    if (producto == NINGUN_PRODUCTO) return -1;
+    return (*productos)[producto];
+}
+
+bool Almacen::ubicar_prod(IdProducto id_producto, ostream &os) const {
+    Producto producto = catalogo->codigo(id_producto);
+    if (producto == NINGUN_PRODUCTO) return false;
+    map<IdSala, int>::const_iterator it;
+    for (it = ubicaciones[producto].begin(); it != ubicaciones[producto].end();
+         ++it) {
+        os << "  " << it->first << ' ' << it->second;
+        sala(it->first).escribir_posiciones(os, producto);
+        os << '\n';
+    }
+    return true;
+}
+
+int Almacen::consultar_cantidad(Producto producto) const {
+    return (*productos)[producto];
+}
+
+const Catalogo &Almacen::consultar_catalogo() const {
+    return *catalogo;
+}
+
+const Sala &Almacen::consultar_sala(IdSala id_sala) const {
+    return sala(id_sala);
+}
+
+Trabajo Almacen::consultar_trabajo() const {
+    Trabajo t = trabajo;
+    t.comparaciones = catalogo->comparaciones();
+    return t;
 }
 
 /*-----+
@@ -103,28 +312,84 @@ int Almacen::consultar_prod(IdProducto id_producto) const {
  +-----*/
 
 void Almacen::inventario(ostream &os) const {
-    Inventario::const_iterator it;
-    for (it = productos.begin(); it != productos.end(); ++it) {
-        os << "  " << it->first << " " << it->second << endl;
+    for (Producto producto : catalogo->ordenados()) {
+        os << "  " << catalogo->nombre(producto) << " "
+           << (*productos)[producto] << '\n';
     }
 }
 
-void Almacen::leer(istream &is) {
+void Almacen::leer(Lector &lector) {
     int num_salas;
-    is >> num_salas;
+    lector.leer(num_salas);
 
-    leer_estructura(is, estructura_salas);
+    estructura_salas.reserve(num_salas);
+    preorden = vector<int>(num_salas);
+    leer_estructura(lector);
 
-    salas = vector<Sala>(num_salas);
+    salas = vector<shared_ptr<Sala> >(num_salas);
+    sala_compartida = vector<char>(num_salas, false);
+    libre = vector<int>(num_salas + 1, 0);
     for (int i = 0; i < num_salas; ++i) {
         int filas, columnas;
-        is >> filas >> columnas;
-        salas[i] = Sala(filas, columnas);
+        lector.leer(filas);
+        lector.leer(columnas);
+        salas[i] = make_shared<Sala>(filas, columnas);
+        actualizar_libre(i + 1, filas * columnas);
     }
 }
 
 void Almacen::escribir(IdSala id_sala, ostream &os) const {
-    sala(id_sala).escribir(os);
+    sala(id_sala).escribir(os, *catalogo);
+}
+
+/*-------------+
+ | Instantáneas |
+ +-------------*/
+
+bool Almacen::guardar(const string &fichero) const {
+    string temporal = fichero + ".tmp";
+    int fd = open(temporal.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok;
+    {
+        Salida salida(fd, 1 << 20);
+        ostream os(&salida);
+        escribir_binario(os, CABECERA, sizeof CABECERA);
+        escribir_binario(os, int(salas.size()));
+        escribir_binario(os, estructura_salas.data(), estructura_salas.size());
+        catalogo->guardar(os);
+        for (int i = 0; i < salas.size(); ++i) salas[i]->guardar(os);
+        os.flush();
+        ok = os.good();
+    }
+    ok = ok and fsync(fd) == 0;
+    ok = close(fd) == 0 and ok;
+    ok = ok and rename(temporal.c_str(), fichero.c_str()) == 0;
+    if (not ok) unlink(temporal.c_str());
+    return ok and sincronizar_directorio(fichero);
+}
+
+bool Almacen::cargar(const string &fichero) {
+    int fd = open(fichero.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 or st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *datos = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (datos == MAP_FAILED) return false;
+    madvise(datos, st.st_size, MADV_SEQUENTIAL);
+
+    LectorBinario lector(static_cast<const char *>(datos), st.st_size);
+    Almacen nuevo;
+    bool ok = nuevo.leer_instantanea(lector);
+    munmap(datos, st.st_size);
+    if (not ok) return false;
+    nuevo.trabajo = trabajo;
+    *this = move(nuevo);
+    return true;
 }
 
 /*---------------------+
@@ -132,34 +397,228 @@ void Almacen::escribir(IdSala id_sala, ostream &os) const {
  +---------------------*/
 
 int Almacen::poner_items(IdSala id_sala, IdProducto id_producto, int cantidad) {
-    Inventario::iterator it = productos.find(id_producto);
-    if (it == productos.end()) return -1; // El producto no existe
-    int sobran = sala(id_sala).poner_items(id_producto, cantidad);
-    it->second += cantidad - sobran;
+    Producto producto = catalogo->codigo(id_producto);
+    if (producto == NINGUN_PRODUCTO) return -1; // El producto no existe
+    int sobran = sala(id_sala).poner_items(producto, cantidad);
+    productos_propios()[producto] += cantidad - sobran;
+    anotar_ubicacion(producto, id_sala, cantidad - sobran);
+    trabajo.posiciones_ocupadas += cantidad - sobran;
+    actualizar_libre(id_sala, sobran - cantidad);
     return sobran;
 }
 
 int Almacen::quitar_items(IdSala id_sala, IdProducto id_producto,
                           int cantidad) {
-    Inventario::iterator it = productos.find(id_producto);
-    if (it == productos.end()) return -1; // El producto no existe
-    int faltan = sala(id_sala).quitar_items(id_producto, cantidad);
-    it->second -= cantidad - faltan;
+    Producto producto = catalogo->codigo(id_producto);
+    if (producto == NINGUN_PRODUCTO) return -1; // El producto no existe
+    int faltan = sala(id_sala).quitar_items(producto, cantidad);
+    productos_propios()[producto] -= cantidad - faltan;
+    anotar_ubicacion(producto, id_sala, faltan - cantidad);
+    trabajo.posiciones_liberadas += cantidad - faltan;
+    actualizar_libre(id_sala, cantidad - faltan);
     return faltan;
 }
 
+vector<int> Almacen::aplicar_lote(const vector<OperacionLote> &operaciones) {
+    int n = operaciones.size();
+    vector<int> resultados(n, -1);
+
+    // Resuelve los productos (a menudo se repiten seguidos) y ordena las
+    // operaciones válidas por sala, sin cambiar el orden dentro de cada sala
+    vector<Producto> codigos(n, NINGUN_PRODUCTO);
+    vector<int> orden;
+    orden.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        assert(operaciones[i].cantidad >= 0);
+        if (i > 0 and
+            operaciones[i].id_producto == operaciones[i - 1].id_producto) {
+            codigos[i] = codigos[i - 1];
+        } else {
+            codigos[i] = catalogo->codigo(operaciones[i].id_producto);
+        }
+        if (codigos[i] != NINGUN_PRODUCTO) orden.push_back(i);
+    }
+    stable_sort(orden.begin(), orden.end(), [&operaciones](int a, int b) {
+        return operaciones[a].id_sala < operaciones[b].id_sala;
+    });
+
+    vector<OperacionSala> ops_sala;
+    vector<int> res_sala;
+    for (int ini = 0, fin; ini < orden.size(); ini = fin) {
+        IdSala id_sala = operaciones[orden[ini]].id_sala;
+        for (fin = ini; fin < orden.size() and
+                        operaciones[orden[fin]].id_sala == id_sala;
+             ++fin) {
+        }
+        ops_sala.clear();
+        for (int k = ini; k < fin; ++k) {
+            const OperacionLote &op = operaciones[orden[k]];
+            ops_sala.push_back({codigos[orden[k]], op.cantidad, op.poner});
+        }
+        sala(id_sala).aplicar_lote(ops_sala, res_sala);
+
+        // Variación neta de cada producto en la sala
+        map<Producto, int> variacion;
+        int libre_sala = 0;
+        for (int k = ini; k < fin; ++k) {
+            int i = orden[k];
+            resultados[i] = res_sala[k - ini];
+            int hechos = operaciones[i].cantidad - resultados[i];
+            if (operaciones[i].poner) {
+                trabajo.posiciones_ocupadas += hechos;
+                variacion[codigos[i]] += hechos;
+                libre_sala -= hechos;
+            } else {
+                trabajo.posiciones_liberadas += hechos;
+                variacion[codigos[i]] -= hechos;
+                libre_sala += hechos;
+            }
+        }
+        for (const pair<const Producto, int> &v : variacion) {
+            productos_propios()[v.first] += v.second;
+            anotar_ubicacion(v.first, id_sala, v.second);
+        }
+        if (libre_sala != 0) actualizar_libre(id_sala, libre_sala);
+    }
+    return resultados;
+}
+
 void Almacen::compactar(IdSala id_sala) {
     sala(id_sala).compactar();
 }
 
 void Almacen::reorganizar(IdSala id_sala) {
-    sala(id_sala).reorganizar();
+    sala(id_sala).reorganizar(*catalogo);
 }
 
 bool Almacen::redimensionar(IdSala id_sala, int filas, int columnas) {
-    return sala(id_sala).redimensionar(filas, columnas);
+    Sala &s = sala(id_sala);
+    int libre_antes = s.espacio_libre();
+    if (not s.redimensionar(filas, columnas)) return false;
+    actualizar_libre(id_sala, s.espacio_libre() - libre_antes);
+    return true;
 }
 
 IdProducto Almacen::consultar_pos(IdSala id_sala, int f, int c) const {
-    return sala(id_sala).consultar_pos(f, c);
+    Producto producto = sala(id_sala).consultar_pos(f, c);
+    if (producto == NINGUN_PRODUCTO) return "NULL";
+    return catalogo->nombre(producto);
+}
+
+bool Almacen::sala_valida(IdSala id_sala) const {
+    return 0 < id_sala and id_sala <= salas.size();
+}
+
+bool Almacen::posicion_valida(IdSala id_sala, int f, int c) const {
+    return sala_valida(id_sala) and sala(id_sala).posicion_valida(f, c);
+}
+
+/*-----------------------+
+ | Operaciones diferidas |
+ +-----------------------*/
+
+int Almacen::poner_items(IdSala id_sala, IdProducto id_producto, int cantidad,
+                         CambiosSala &cambios) {
+    Producto producto = catalogo->codigo(id_producto);
+    if (producto == NINGUN_PRODUCTO) return -1; // El producto no existe
+    int sobran = sala(id_sala).poner_items(producto, cantidad);
+    if (sobran < cantidad) {
+        cambios.movimientos.push_back({producto, id_sala, cantidad - sobran});
+        cambios.libre.push_back({id_sala, sobran - cantidad});
+        cambios.trabajo.posiciones_ocupadas += cantidad - sobran;
+    }
+    return sobran;
+}
+
+int Almacen::quitar_items(IdSala id_sala, IdProducto id_producto,
+                          int cantidad, CambiosSala &cambios) {
+    Producto producto = catalogo->codigo(id_producto);
+    if (producto == NINGUN_PRODUCTO) return -1; // El producto no existe
+    int faltan = sala(id_sala).quitar_items(producto, cantidad);
+    if (faltan < cantidad) {
+        cambios.movimientos.push_back({producto, id_sala, faltan - cantidad});
+        cambios.libre.push_back({id_sala, cantidad - faltan});
+        cambios.trabajo.posiciones_liberadas += cantidad - faltan;
+    }
+    return faltan;
+}
+
+bool Almacen::redimensionar(IdSala id_sala, int filas, int columnas,
+                            CambiosSala &cambios) {
+    Sala &s = sala(id_sala);
+    int libre_antes = s.espacio_libre();
+    if (not s.redimensionar(filas, columnas)) return false;
+    cambios.libre.push_back({id_sala, s.espacio_libre() - libre_antes});
+    return true;
+}
+
+void Almacen::aplicar_productos(const CambiosSala &cambios, int parte,
+                                int partes) {
+    assert(0 <= parte and parte < partes and not productos_compartidos);
+    for (const CambiosSala::Movimiento &m : cambios.movimientos) {
+        if (m.producto % partes != parte) continue;
+        (*productos)[m.producto] += m.items;
+        anotar_ubicacion(m.producto, m.id_sala, m.items);
+    }
+}
+
+void Almacen::aplicar_salas(const CambiosSala &cambios) {
+    for (const pair<IdSala, int> &l : cambios.libre) {
+        actualizar_libre(l.first, l.second);
+    }
+    trabajo.posiciones_ocupadas += cambios.trabajo.posiciones_ocupadas;
+    trabajo.posiciones_liberadas += cambios.trabajo.posiciones_liberadas;
+    trabajo.salas_visitadas += cambios.trabajo.salas_visitadas;
+}
+
+void Almacen::separar_inventario() {
+    productos_propios();
+}
+
+/*--------+
+ | Vistas |
+ +--------*/
+
+VistaAlmacen Almacen::vista() {
+    // La caché del catálogo no se protege como la de las salas: se pone al
+    // día aquí (sólo fusiona las altas desde la última vez).
+    catalogo->ordenados();
+
+    VistaAlmacen vista;
+    vista.salas.assign(salas.begin(), salas.end());
+    vista.catalogo = catalogo;
+    vista.productos = productos;
+    sala_compartida.assign(salas.size(), true);
+    catalogo_compartido = true;
+    productos_compartidos = true;
+    return vista;
+}
+
+int VistaAlmacen::num_salas() const {
+    return salas.size();
+}
+
+int VistaAlmacen::consultar_prod(IdProducto id_producto) const {
+    Producto producto = catalogo->codigo(id_producto);
+    if (producto == NINGUN_PRODUCTO) return -1;
+    return (*productos)[producto];
+}
+
+IdProducto VistaAlmacen::consultar_pos(IdSala id_sala, int f, int c) const {
+    assert(0 < id_sala and id_sala <= salas.size());
+    Producto producto = salas[id_sala - 1]->consultar_pos(f, c);
+    if (producto == NINGUN_PRODUCTO) return "NULL";
+    return catalogo->nombre(producto);
+}
+
+void VistaAlmacen::inventario(ostream &os) const {
+    for (Producto producto : catalogo->ordenados()) {
+        os << "  " << catalogo->nombre(producto) << " "
+           << (*productos)[producto] << '\n';
+    }
+}
+
+void VistaAlmacen::escribir(IdSala id_sala, ostream &os) const {
+    assert(0 < id_sala and id_sala <= salas.size());
+    salas[id_sala - 1]->escribir(os, *catalogo);
 }
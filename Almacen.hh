@@ -4,55 +4,320 @@
 #ifndef ALMACEN_HH
 #define ALMACEN_HH
 
+#include "Binario.hh"
+#include "Catalogo.hh"
+#include "Lector.hh"
 #include "Sala.hh"
 #include "aux.hh"
 #ifndef NO_DIAGRAM
-#    include "BinTree.hh"
-#    include <istream>
+#    include <memory>
 #    include <ostream>
 #endif // NO_DIAGRAM
 
 using namespace std;
 
+/** Contadores del trabajo hecho por un Almacen desde que se creó (ver
+ * Almacen::consultar_trabajo).
+ */
+struct Trabajo {
+    /// Posiciones ocupadas por @c poner_items y @c distribuir.
+    long long posiciones_ocupadas;
+    /// Posiciones liberadas por @c quitar_items.
+    long long posiciones_liberadas;
+    /// Salas en las que @c distribuir ha intentado poner ítems.
+    long long salas_visitadas;
+    /** Comparaciones de identificadores de producto (al ordenar los
+     * productos de una sala para @c reorganizar o @c escribir).
+     */
+    long long comparaciones;
+};
+
+/** Operación de un lote de poner y quitar ítems (ver Almacen::aplicar_lote).
+ */
+struct OperacionLote {
+    /// Sala sobre la que se opera.
+    IdSala id_sala;
+    /// Producto sobre el que se opera.
+    IdProducto id_producto;
+    /// Cantidad de ítems (>= 0).
+    int cantidad;
+    /// Si es un @c poner_items (@c true) o un @c quitar_items (@c false).
+    bool poner;
+};
+
+/** Cambios en el estado global de un Almacen hechos por operaciones sobre
+ * una sola sala que todavía no se han aplicado (ver las operaciones
+ * diferidas de Almacen).
+ *
+ * Permiten operar a la vez sobre salas distintas desde varios hilos (ver
+ * EjecutorParalelo): cada hilo anota sus cambios aparte, y se aplican todos
+ * cuando han terminado.
+ */
+struct CambiosSala {
+    /// Variación de los ítems de un producto en una sala.
+    struct Movimiento {
+        /// Código del producto.
+        Producto producto;
+        /// Sala.
+        IdSala id_sala;
+        /// Variación del número de ítems.
+        int items;
+    };
+
+    /// Variaciones de ítems, en orden.
+    vector<Movimiento> movimientos;
+    /// Variaciones del espacio libre de las salas: [sala, variación].
+    vector<pair<IdSala, int> > libre;
+    /// Trabajo hecho (sin contar las comparaciones).
+    Trabajo trabajo;
+
+    /// Crea un conjunto de cambios vacío.
+    CambiosSala() : trabajo() {}
+
+    /// Vacía los cambios (después de aplicarlos).
+    void limpiar() {
+        movimientos.clear();
+        libre.clear();
+        trabajo = Trabajo();
+    }
+};
+
+/** Vista inmutable de un Almacen en un momento dado (ver Almacen::vista).
+ *
+ * Responde a las consultas como el almacén en el momento de crearla, aunque
+ * después se modifique. Todos sus métodos son consultores y no modifican
+ * nada, así que se pueden llamar desde varios hilos a la vez, mientras el
+ * almacén se sigue modificando desde otro.
+ */
+class VistaAlmacen {
+private:
+    friend class Almacen;
+
+    /// Salas, con la sala n en salas[n-1].
+    vector<shared_ptr<const Sala> > salas;
+    /// Catálogo de los productos.
+    shared_ptr<const Catalogo> catalogo;
+    /// Número de ítems de cada producto, indexado por su código.
+    shared_ptr<const vector<int> > productos;
+
+public:
+    /// Número de salas.
+    int num_salas() const;
+
+    /** Consultar la cantidad de ítems de un producto.
+     *
+     * @see
+     * Almacen::consultar_prod
+     */
+    int consultar_prod(IdProducto id_producto) const;
+
+    /** Consultar el producto de una posición de una sala.
+     *
+     * @see
+     * Almacen::consultar_pos
+     */
+    IdProducto consultar_pos(IdSala id_sala, int f, int c) const;
+
+    /** Escribir el inventario.
+     *
+     * @see
+     * Almacen::inventario
+     */
+    void inventario(ostream &os) const;
+
+    /** Escribir una sala.
+     *
+     * @see
+     * Almacen::escribir
+     */
+    void escribir(IdSala id_sala, ostream &os) const;
+};
+
 /** Representación de un almacén. */
 class Almacen {
 private:
-    /** Árbol con la estructura de las salas.
+    /** Nodo del árbol de salas.
+     *
+     * Los nodos se guardan en un vector en preorden, y los hijos se indican
+     * con su posición en este vector (o -1 si no hay). Así el recorrido del
+     * árbol no persigue punteros ni copia @c shared_ptr.
+     */
+    struct Nodo {
+        /// Identificador de la sala.
+        IdSala id_sala;
+        /// Posición del hijo izquierdo, o -1.
+        int izquierdo;
+        /// Posición del hijo derecho, o -1.
+        int derecho;
+        /** Número de nodos del subárbol. Ocupan las posiciones [posición del
+         * nodo, posición del nodo + @c tam).
+         */
+        int tam;
+    };
+
+    /** Árbol con la estructura de las salas, como un vector de @ref Nodo en
+     * preorden.
      *
      * Cada nodo contiene el identificador de la sala, y conectado a este, las
-     * tres salas a las que se puede acceder (o una, si es una hoja).
+     * tres salas a las que se puede acceder (o una, si es una hoja). La raíz
+     * está en la posición 0.
+     */
+    vector<Nodo> estructura_salas;
+
+    /** Vector que contiene todas las salas, con la sala n en salas[n-1].
+     *
+     * Las salas se pueden compartir con las vistas (ver vista()): se copian
+     * la primera vez que se modifican después de crear una vista (ver
+     * sala(IdSala)).
+     */
+    vector<shared_ptr<Sala> > salas;
+
+    /** Indica, para cada sala, si @ref salas la comparte con alguna vista
+     * (@c char y no @c bool para que los hilos de EjecutorParalelo puedan
+     * modificar salas distintas a la vez).
+     */
+    vector<char> sala_compartida;
+
+    /** Posición de cada sala en @ref estructura_salas, con la posición de la
+     * sala n en preorden[n-1].
      */
-    BinTree<IdSala> estructura_salas;
-    /// Vector que contiene todas las salas, con la sala n en salas[n-1].
-    vector<Sala> salas;
-    /** Inventario de todos los productos en el almacén.
+    vector<int> preorden;
+
+    /** Espacio libre de las salas, como un árbol de Fenwick indexado por la
+     * posición en preorden (más uno) de cada sala.
+     *
+     * Permite consultar el espacio libre de cualquier subárbol de @ref
+     * estructura_salas (un intervalo del preorden) y actualizarlo cuando
+     * cambia una sala, ambos en tiempo logarítmico en el número de salas. Así
+     * distribuir() puede descartar de golpe los subárboles llenos.
+     *
+     * @invariant
+     * <tt>libre.size() == salas.size() + 1</tt>; la suma de las posiciones
+     * [1, i] es el espacio libre de las i primeras salas en preorden.
+     */
+    vector<int> libre;
+
+    /** Catálogo con los productos dados de alta en el almacén.
+     *
+     * Las salas guardan los códigos que asigna; los identificadores sólo se
+     * usan en la entrada/salida. Se puede compartir con las vistas, como
+     * las salas: se modifica con catalogo_propio().
+     */
+    shared_ptr<Catalogo> catalogo;
+
+    /// Indica si @ref catalogo se comparte con alguna vista.
+    bool catalogo_compartido;
+
+    /** Inventario de todos los productos en el almacén, indexado por el código
+     * del producto.
      *
      * Un producto puede tener 0 ítems cuando ha sido dado de alta, pero no
      * tiene ningún ítem en ninguna sala.
+     *
+     * @invariant
+     * <tt>productos->size() >= catalogo->max_codigo()</tt>; para cada
+     * producto del catálogo, @c productos contiene su número de ítems.
+     *
+     * Se puede compartir con las vistas, como las salas: se modifica con
+     * productos_propios().
      */
-    Inventario productos;
+    shared_ptr<vector<int> > productos;
+
+    /// Indica si @ref productos se comparte con alguna vista.
+    bool productos_compartidos;
+
+    /** Índice inverso del inventario: salas en las que hay ítems de cada
+     * producto, con su número de ítems, indexado por el código del producto.
+     *
+     * Se actualiza en cada operación que pone o quita ítems, de forma que
+     * ubicar_prod() no tiene que recorrer las salas.
+     *
+     * @invariant
+     * <tt>ubicaciones.size() == productos->size()</tt>;
+     * <tt>ubicaciones[p]</tt> contiene exactamente las salas con algún ítem
+     * de @c p, con su número de ítems (> 0), y la suma de estos números es
+     * <tt>(*productos)[p]</tt>.
+     */
+    vector<map<IdSala, int> > ubicaciones;
+
+    /** Trabajo hecho hasta ahora. Las comparaciones las cuenta @ref
+     * catalogo: el campo @c comparaciones no se usa.
+     */
+    Trabajo trabajo;
 
     /** Leer la estructura del árbol de salas en preorden.
      *
-     * @param is
-     * Stream desde el que se leerá el árbol.
+     * El árbol se lee en una sola pasada con una pila explícita, sin
+     * recursividad, de forma que los árboles muy profundos (p.ej. una cadena
+     * de salas) no desbordan la pila del programa.
      *
-     * @param[out] tree
-     * Árbol de identificadores de salas.
+     * @param lector
+     * Lector desde el que se leerá el árbol.
      *
      * @pre
-     * Hay un árbol válido en @c is.
+     * Hay un árbol válido en @c lector, con @ref num_salas nodos; @ref
+     * preorden tiene tamaño @ref num_salas.
      *
      * @post
-     * Se han leído elementos de @c is hasta formar un árbol (en preorden, con 0
-     * indicando el árbol nulo), que se encuentra en @c tree.
+     * Se han leído elementos de @c lector hasta formar un árbol (en preorden, con 0
+     * indicando el árbol nulo), que se encuentra en @ref estructura_salas; @ref
+     * preorden contiene la posición de cada sala.
      *
      * @cost
      * Lineal respecto al número de nodos del árbol.
      */
-    static void leer_estructura(istream &is, BinTree<IdSala> &tree);
+    void leer_estructura(Lector &lector);
+
+    /** Actualizar el espacio libre de una sala en @ref libre.
+     *
+     * @param id_sala
+     * Identificador de la sala.
+     *
+     * @param delta
+     * Variación del espacio libre de la sala.
+     *
+     * @pre
+     * 1 <= @c id_sala <= número de salas
+     *
+     * @cost
+     * Logarítmico en el número de salas
+     */
+    void actualizar_libre(IdSala id_sala, int delta);
+
+    /** Consultar el espacio libre de un subárbol.
+     *
+     * @param nodo
+     * Posición de la raíz del subárbol en @ref estructura_salas.
+     *
+     * @returns
+     * La suma del espacio libre de las salas del subárbol de @ref
+     * estructura_salas con raíz @c nodo.
+     *
+     * @pre
+     * 0 <= @c nodo < número de salas
+     *
+     * @cost
+     * Logarítmico en el número de salas
+     */
+    int libre_subarbol(int nodo) const;
 
-    /** Obtener una sala.
+    /** Actualizar @ref ubicaciones tras poner o quitar ítems de una sala.
+     *
+     * @param producto
+     * Código del producto.
+     *
+     * @param id_sala
+     * Identificador de la sala.
+     *
+     * @param delta
+     * Variación del número de ítems de @c producto en la sala.
+     *
+     * @cost
+     * Logarítmico en el número de salas con ítems del producto
+     */
+    void anotar_ubicacion(Producto producto, IdSala id_sala, int delta);
+
+    /** Obtener una sala para modificarla.
      *
      * @param id_sala
      * Identificador de la sala.
@@ -63,23 +328,55 @@ private:
      * @pre
      * 1 <= @c id_sala <= número de salas
      *
+     * @post
+     * La sala no se comparte con ninguna vista: si se compartía, se ha
+     * copiado.
+     *
      * @cost
-     * Constante
+     * Constante si la sala no se compartía; si no, lineal en su tamaño
      */
     Sala &sala(IdSala id_sala);
 
-    /** Igual que sala(IdSala), pero devuelve una referencia constante. */
+    /** Igual que sala(IdSala), pero devuelve una referencia constante (y
+     * nunca copia la sala). */
     const Sala &sala(IdSala id_sala) const;
 
+    /** Obtener el catálogo para modificarlo.
+     *
+     * @post
+     * @ref catalogo no se comparte con ninguna vista: si se compartía, se ha
+     * copiado.
+     *
+     * @cost
+     * Constante si el catálogo no se compartía; si no, lineal en su tamaño
+     */
+    Catalogo &catalogo_propio();
+
+    /** Obtener el inventario para modificarlo.
+     *
+     * @post
+     * @ref productos no se comparte con ninguna vista: si se compartía, se ha
+     * copiado.
+     *
+     * @cost
+     * Constante si el inventario no se compartía; si no, lineal en el número
+     * de productos
+     */
+    vector<int> &productos_propios();
+
     /** Función de inmersión de distribuir().
      *
-     * @param tree
-     * Árbol que se usará para determinar en qué sala se pondrán los ítems.
-     * Este árbol contendrá los identificadores de sala. El árbol puede estar
-     * vacío, en cuyo caso no se pondrá ningún ítem.
+     * Recorre el árbol con una pila explícita, sin recursividad. Como los
+     * subárboles no comparten salas, el orden en el que se visitan no afecta
+     * al resultado.
      *
-     * @param id_producto
-     * Identificador del producto.
+     * @param nodo
+     * Posición en @ref estructura_salas de la raíz del subárbol que se usará
+     * para determinar en qué sala se pondrán los ítems. Puede ser -1 (árbol
+     * vacío), en cuyo caso no se pondrá ningún ítem.
+     *
+     * @param producto
+     * Código del producto.
      *
      * @param cantidad
      * Cantidad de ítems del producto
@@ -88,17 +385,42 @@ private:
      * Número de ítems que no se han podido almacenar.
      *
      * @pre
-     * @c id_producto existe (es decir, está en el inventario).
+     * @c producto existe (es decir, está en el catálogo).
      *
      * @post
      * Los ítems han sido distribuidos por el almacén, según la política de
-     * distribución.
+     * distribución, y @ref libre está actualizado.
      *
      * @cost
-     * Lineal respecto a @c cantidad
+     * Lineal respecto a @c cantidad y logarítmico en el número de salas por
+     * cada sala visitada. No se visitan los subárboles llenos.
      */
-    int i_distribuir(const BinTree<IdSala> &tree, IdProducto id_producto,
-                     int cantidad);
+    int i_distribuir(int nodo, Producto producto, int cantidad);
+
+    /** Lee una instantánea (ver guardar()) de un bloque de memoria.
+     *
+     * Comprueba que la instantánea es coherente: las longitudes caben en lo
+     * que queda del bloque, el árbol tiene forma de árbol en preorden, las
+     * salas tienen dimensiones válidas y sólo contienen productos del
+     * catálogo. Las cantidades del inventario global se recalculan a partir
+     * de las salas.
+     *
+     * @param lector
+     * Lector del bloque.
+     *
+     * @retval true
+     * Se ha leído una instantánea válida.
+     *
+     * @retval false
+     * La instantánea no es válida; el objeto puede haber quedado a medias.
+     *
+     * @pre
+     * El objeto está vacío (recién construido).
+     *
+     * @cost
+     * El de cargar()
+     */
+    bool leer_instantanea(LectorBinario &lector);
 
 public:
     /** Crea un almacén vacío.
@@ -108,6 +430,27 @@ public:
      */
     Almacen();
 
+    /** Crea una copia de otro almacén, que no comparte nada con él ni con
+     * sus vistas.
+     *
+     * @cost
+     * Lineal en el tamaño de @c otro
+     */
+    Almacen(const Almacen &otro);
+
+    /** Mueve otro almacén (que después sólo se puede destruir o asignar);
+     * sus vistas siguen siendo válidas.
+     */
+    Almacen(Almacen &&otro) = default;
+
+    /** Sustituye el almacén por una copia de @c otro (ver
+     * Almacen(const Almacen &)).
+     */
+    Almacen &operator=(const Almacen &otro);
+
+    /// Sustituye el almacén por @c otro; las vistas siguen siendo válidas.
+    Almacen &operator=(Almacen &&otro) = default;
+
     /** Añadir un producto.
      *
      * @param id_producto
@@ -123,7 +466,7 @@ public:
      * Si el producto @c id_producto no existía, ha sido añadido con 0 unidades.
      *
      * @cost
-     * Logarítmico en la cantidad de productos ya existentes
+     * Constante (esperado y amortizado)
      */
     bool poner_prod(IdProducto id_producto);
 
@@ -140,7 +483,7 @@ public:
      * ha sido modificado.
      *
      * @cost
-     * Logarítmico en la cantidad de productos
+     * Constante (esperado)
      *
      * @post
      * Si el producto @c id_producto existía y tenía 0 unidades, ha sido
@@ -183,7 +526,8 @@ public:
      * almacén está lleno.
      *
      * @cost
-     * Lineal respecto a @c cantidad
+     * Lineal respecto a @c cantidad, logarítmico en el número de salas por
+     * cada sala visitada
      */
     int distribuir(IdProducto id_producto, int cantidad);
 
@@ -215,10 +559,73 @@ public:
      * El producto @c id_producto no existe.
      *
      * @cost
-     * Logarítmico en el número de productos
+     * Constante (esperado)
      */
     int consultar_prod(IdProducto id_producto) const;
 
+    /** Consultar dónde está un producto.
+     *
+     * Escribe una línea por cada sala (en orden creciente de identificador)
+     * que tiene ítems del producto: el identificador de la sala, el número de
+     * ítems y las posiciones <tt>f,c</tt> que ocupan, en un orden cualquiera.
+     *
+     * @param id_producto
+     * Identificador del producto.
+     *
+     * @param os
+     * Stream de salida.
+     *
+     * @retval true
+     * Se han escrito las ubicaciones del producto.
+     *
+     * @retval false
+     * El producto @c id_producto no existe. No se ha escrito nada.
+     *
+     * @cost
+     * Constante (esperado), más lineal en la salida (el
+     * número de salas y posiciones con el producto)
+     */
+    bool ubicar_prod(IdProducto id_producto, ostream &os) const;
+
+    /** Consultar el número de ítems de un producto por su código (ver
+     * consultar_catalogo()).
+     *
+     * @pre
+     * El producto existe.
+     *
+     * @cost
+     * Constante
+     */
+    int consultar_cantidad(Producto producto) const;
+
+    /** Consultar el catálogo, con el código y el identificador de cada
+     * producto (p.ej. para escribir el inventario en binario).
+     *
+     * @cost
+     * Constante
+     */
+    const Catalogo &consultar_catalogo() const;
+
+    /** Consultar una sala (p.ej. para escribirla en binario).
+     *
+     * @pre
+     * sala_valida(@c id_sala).
+     *
+     * @cost
+     * Constante
+     */
+    const Sala &consultar_sala(IdSala id_sala) const;
+
+    /** Consultar el trabajo hecho por el almacén desde que se creó.
+     *
+     * Los contadores se actualizan siempre (cuestan una suma por
+     * operación); sirven para las estadísticas del programa.
+     *
+     * @cost
+     * Constante
+     */
+    Trabajo consultar_trabajo() const;
+
     /** Inventario de los productos.
      * @param os
      * Stream de salida.
@@ -227,28 +634,29 @@ public:
      * El contenido del inventario se ha escrito por orden alfabético en @c os
      *
      * @cost
-     * Lineal en el número de productos
+     * Lineal en el número de productos, más ordenarlos si se ha dado de alta
+     * o de baja alguno desde el último inventario (ver Catalogo::ordenados)
      */
     void inventario(ostream &os) const;
 
-    /** Lee las salas por un stream.
+    /** Lee las salas de la entrada.
      *
-     * @param is
-     * Stream para leer.
+     * @param lector
+     * Lector de la entrada.
      *
      * @pre
-     * @c is contiene el número de salas (@em n), un árbol en preorden y las
-     * dimensiones de las salas (&rArr; @c is no está vacío); el árbol en @c is
-     * tiene @em n nodos, numerados de 1 a @em n.
+     * @c lector contiene el número de salas (@em n), un árbol en preorden y
+     * las dimensiones de las salas (&rArr; @c lector no está vacío); el árbol
+     * en @c lector tiene @em n nodos, numerados de 1 a @em n.
      *
      * @post
      * El objeto ahora tiene @em n salas con la estructura y dimensiones
-     * dadas en @c is.
+     * dadas en @c lector.
      *
      * @cost
      * Lineal en el número de salas
      */
-    void leer(istream &is);
+    void leer(Lector &lector);
 
     //--------------------
     // Operaciones de sala
@@ -281,8 +689,8 @@ public:
      * objeto.
      *
      * @cost
-     * Lineal en la cantidad de ítems añadidos, logarítmico en la cantidad de
-     * productos del almacén
+     * Lineal en la cantidad de ítems añadidos, más constante (esperado) para
+     * encontrar el producto
      *
      * @see
      * Sala::poner_items
@@ -317,14 +725,45 @@ public:
      * ha modificado el objeto.
      *
      * @cost
-     * Lineal en la cantidad de ítems añadidos, logarítmico en la cantidad de
-     * productos del almacén
+     * Lineal en la cantidad de ítems añadidos, más constante (esperado) para
+     * encontrar el producto
      *
      * @see
      * Sala::quitar_items
      */
     int quitar_items(IdSala id_sala, IdProducto id_producto, int cantidad);
 
+    /** Aplicar un lote de operaciones de poner y quitar ítems.
+     *
+     * El resultado es idéntico a ejecutar en orden poner_items() o
+     * quitar_items() con cada operación, pero el lote se trata por salas: las
+     * operaciones de cada sala se aplican juntas (en su orden relativo, que
+     * es lo único que importa, porque las salas son independientes), y el
+     * espacio libre (@ref libre), las ubicaciones y los totales de cada
+     * producto se actualizan una sola vez por sala y producto, en vez de una
+     * vez por operación.
+     *
+     * @param operaciones
+     * Operaciones a aplicar.
+     *
+     * @returns
+     * Para cada operación, lo que habría devuelto poner_items() o
+     * quitar_items(): los ítems que no se han podido poner o quitar, o -1 si
+     * el producto no existe.
+     *
+     * @pre
+     * Para cada operación, @c cantidad >= 0 y
+     * 0 < @c id_sala <= @ref num_salas.
+     *
+     * @cost
+     * El de las operaciones de las salas, más O(@e n log @e n) en el número
+     * de operaciones
+     *
+     * @see
+     * Sala::aplicar_lote
+     */
+    vector<int> aplicar_lote(const vector<OperacionLote> &operaciones);
+
     /** Compactar la estantería de una sala.
      *
      * @param id_sala
@@ -412,6 +851,21 @@ public:
      */
     IdProducto consultar_pos(IdSala id_sala, int f, int c) const;
 
+    /** Indica si @c id_sala es una sala del almacén.
+     *
+     * @cost
+     * Constante
+     */
+    bool sala_valida(IdSala id_sala) const;
+
+    /** Indica si (@c f, @c c) es una posición de la estantería de la sala
+     * @c id_sala (y la sala existe).
+     *
+     * @cost
+     * Constante
+     */
+    bool posicion_valida(IdSala id_sala, int f, int c) const;
+
     /** Escribe la estantería.
      *
      * @param id_sala
@@ -434,6 +888,171 @@ public:
      * Sala::escribir
      */
     void escribir(IdSala id_sala, ostream &os) const;
+
+    //-----------------------
+    // Operaciones diferidas
+    //-----------------------
+
+    // Versiones de las operaciones de sala que modifican el estado global
+    // (totales de los productos, ubicaciones, espacio libre y trabajo) que
+    // anotan esos cambios en un CambiosSala en vez de aplicarlos. Mientras no
+    // se apliquen con aplicar_productos() y aplicar_salas(), sólo se pueden
+    // hacer operaciones de sala, y las consultas del estado global no los
+    // reflejan. Las operaciones sobre salas distintas se pueden hacer a la
+    // vez desde hilos distintos, con un CambiosSala para cada hilo.
+
+    /** Poner ítems de un producto en una sala, sin aplicar los cambios
+     * globales.
+     *
+     * @see
+     * poner_items(IdSala, IdProducto, int)
+     */
+    int poner_items(IdSala id_sala, IdProducto id_producto, int cantidad,
+                    CambiosSala &cambios);
+
+    /** Quitar ítems de un producto de una sala, sin aplicar los cambios
+     * globales.
+     *
+     * @see
+     * quitar_items(IdSala, IdProducto, int)
+     */
+    int quitar_items(IdSala id_sala, IdProducto id_producto, int cantidad,
+                     CambiosSala &cambios);
+
+    /** Redimensionar una sala, sin aplicar los cambios globales.
+     *
+     * @see
+     * redimensionar(IdSala, int, int)
+     */
+    bool redimensionar(IdSala id_sala, int filas, int columnas,
+                       CambiosSala &cambios);
+
+    /** Aplicar los cambios de los productos (totales y ubicaciones).
+     *
+     * Los productos se reparten en @c partes partes según su código; sólo se
+     * aplican los cambios de la parte @c parte. Así varios hilos pueden
+     * aplicar a la vez partes distintas.
+     *
+     * @param cambios
+     * Cambios a aplicar.
+     *
+     * @param parte, partes
+     * Parte a aplicar (0 <= @c parte < @c partes).
+     *
+     * @pre
+     * El inventario no se comparte con ninguna vista (ver
+     * separar_inventario()).
+     *
+     * @cost
+     * Lineal en el número de movimientos, más logarítmico en el número de
+     * salas del producto por cada movimiento aplicado
+     */
+    void aplicar_productos(const CambiosSala &cambios, int parte, int partes);
+
+    /** Aplicar los cambios del espacio libre y del trabajo.
+     *
+     * @pre
+     * Se han aplicado los cambios de los productos de todas las partes.
+     *
+     * @post
+     * El estado global refleja todas las operaciones de @c cambios.
+     *
+     * @cost
+     * Logarítmico en el número de salas por cada variación del espacio libre
+     */
+    void aplicar_salas(const CambiosSala &cambios);
+
+    /** Copia el inventario si se comparte con alguna vista, de forma que
+     * aplicar_productos() lo pueda modificar desde varios hilos.
+     *
+     * @cost
+     * Constante si el inventario no se compartía; si no, lineal en el número
+     * de productos
+     */
+    void separar_inventario();
+
+    //--------
+    // Vistas
+    //--------
+
+    /** Crea una vista del estado actual del almacén.
+     *
+     * La vista comparte las salas, el catálogo y el inventario con el
+     * almacén, que los copia la primera vez que modifica cada uno (copia al
+     * escribir). Así la vista no cambia aunque se siga modificando el
+     * almacén, y se puede consultar desde otros hilos a la vez.
+     *
+     * Antes de compartirlo, se pone al día la caché del catálogo (ver
+     * Catalogo::ordenados), para que las consultas de la vista no lo
+     * modifiquen.
+     *
+     * @returns
+     * Una vista del almacén.
+     *
+     * @cost
+     * Lineal en el número de salas, más el de poner al día la caché del
+     * catálogo. Después, el almacén copia cada sala, el catálogo y el
+     * inventario la primera vez que los modifica
+     */
+    VistaAlmacen vista();
+
+    //-------------
+    // Instantáneas
+    //-------------
+
+    /** Guarda el almacén en una instantánea binaria.
+     *
+     * La instantánea contiene el árbol de salas, el catálogo (con los
+     * códigos de los productos) y las dimensiones y estanterías de las salas
+     * (con los códigos, no los identificadores); el inventario global se
+     * recalcula al cargarla.
+     * Se escribe en un fichero temporal que sustituye a @c fichero sólo
+     * cuando se ha escrito entero y sincronizado con el disco, de forma que
+     * un fallo a medias no estropea una instantánea anterior; después se
+     * sincroniza el directorio (ver sincronizar_directorio()) para que la
+     * sustitución también sea duradera.
+     *
+     * @param fichero
+     * Ruta del fichero.
+     *
+     * @retval true
+     * Se ha guardado la instantánea.
+     *
+     * @retval false
+     * Ha habido un error de escritura; @c fichero no ha cambiado (o, si el
+     * error ha sido al sincronizar el directorio, puede que ya se haya
+     * sustituido, pero sin garantías de que sobreviva a una caída).
+     *
+     * @cost
+     * Lineal en el número de salas, de productos y de posiciones de las
+     * estanterías
+     *
+     * @see
+     * Binario.hh
+     */
+    bool guardar(const string &fichero) const;
+
+    /** Carga una instantánea guardada con guardar().
+     *
+     * El fichero se proyecta en memoria (con @c mmap) y se recorre una sola
+     * vez. Los contadores de trabajo (ver consultar_trabajo()) se conservan.
+     *
+     * @param fichero
+     * Ruta del fichero.
+     *
+     * @retval true
+     * Se ha cargado la instantánea, que sustituye al almacén actual.
+     *
+     * @retval false
+     * No se ha podido leer el fichero o no es una instantánea válida. El
+     * objeto no ha sido modificado.
+     *
+     * @cost
+     * Lineal en el tamaño de la instantánea, logarítmico en el número de
+     * productos de la sala por cada cambio de producto entre posiciones
+     * consecutivas de una estantería
+     */
+    bool cargar(const string &fichero);
 };
 
 #endif // ALMACEN_HH
@@ -0,0 +1,105 @@
+/** @file
+ * Archivo que define las funciones de escritura y lectura de valores en
+ * binario que usan las instantáneas (ver Almacen::guardar).
+ *
+ * Los valores se escriben tal como están en memoria (con el orden de bytes y
+ * los tamaños de la máquina), así que una instantánea sólo se puede cargar
+ * en una máquina de la misma arquitectura.
+ */
+
+#ifndef BINARIO_HH
+#define BINARIO_HH
+
+#ifndef NO_DIAGRAM
+#    include <cstring>
+#    include <ostream>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Escribe @c n valores en binario.
+ *
+ * @param os
+ * Stream de salida.
+ *
+ * @param v
+ * Primer valor.
+ *
+ * @param n
+ * Número de valores.
+ */
+template <class T> void escribir_binario(ostream &os, const T *v, size_t n) {
+    os.write(reinterpret_cast<const char *>(v), n * sizeof(T));
+}
+
+/// Escribe un valor en binario.
+template <class T> void escribir_binario(ostream &os, const T &v) {
+    escribir_binario(os, &v, 1);
+}
+
+/** Lector de valores en binario de un bloque de memoria (p.ej. un fichero
+ * proyectado con @c mmap).
+ *
+ * Nunca lee fuera del bloque: si no quedan suficientes bytes, la lectura
+ * falla y ya no se lee nada más.
+ */
+class LectorBinario {
+private:
+    /// Siguiente byte a leer.
+    const char *actual;
+    /// Final del bloque.
+    const char *fin;
+
+public:
+    /** Crea un lector del bloque [@c datos, @c datos + @c tam).
+     *
+     * @cost
+     * Constante
+     */
+    LectorBinario(const char *datos, size_t tam)
+        : actual(datos), fin(datos + tam) {}
+
+    /** Lee @c n valores en binario.
+     *
+     * @param[out] v
+     * Primer valor.
+     *
+     * @param n
+     * Número de valores.
+     *
+     * @retval true
+     * Se han leído los valores.
+     *
+     * @retval false
+     * No quedan suficientes bytes; no se ha leído nada.
+     *
+     * @cost
+     * Lineal en @c n
+     */
+    template <class T> bool leer(T *v, size_t n) {
+        if (n > size_t(fin - actual) / sizeof(T)) {
+            actual = fin;
+            return false;
+        }
+        memcpy(v, actual, n * sizeof(T));
+        actual += n * sizeof(T);
+        return true;
+    }
+
+    /// Lee un valor en binario.
+    template <class T> bool leer(T &v) {
+        return leer(&v, 1);
+    }
+
+    /// Número de bytes que quedan por leer.
+    size_t restantes() const {
+        return fin - actual;
+    }
+
+    /// Indica si se ha leído todo el bloque.
+    bool final() const {
+        return actual == fin;
+    }
+};
+
+#endif // BINARIO_HH
@@ -0,0 +1,230 @@
+/** @file
+ * Implementación de Catalogo.
+ */
+#include "Catalogo.hh"
+#ifndef NO_DIAGRAM
+#    include <algorithm> // std::merge, std::reverse, std::sort...
+#    include <cassert>
+#    include <functional> // std::hash
+#    include <utility>    // std::move
+#endif
+
+/// Capacidad mínima de la tabla de dispersión (potencia de 2).
+static const int CAPACIDAD_MINIMA = 16;
+
+/// Valor de dispersión de un identificador.
+static size_t dispersion(const IdProducto &id_producto) {
+    return hash<IdProducto>()(id_producto);
+}
+
+/*------------------+
+ | Métodos privados |
+ +------------------*/
+
+int Catalogo::casilla(const IdProducto &id_producto, size_t h) const {
+    size_t mascara = tabla.size() - 1;
+    for (size_t i = h & mascara;; i = (i + 1) & mascara) {
+        Producto producto = tabla[i];
+        if (producto == NINGUN_PRODUCTO or
+            (dispersiones[producto] == h and nombres[producto] == id_producto))
+            return i;
+    }
+}
+
+void Catalogo::redispersar(int capacidad) {
+    assert(capacidad >= 2 * num_productos);
+    tabla.assign(capacidad, NINGUN_PRODUCTO);
+    size_t mascara = capacidad - 1;
+    for (Producto producto = 1; producto < nombres.size(); ++producto) {
+        if (nombres[producto].empty()) continue;
+        size_t i = dispersiones[producto] & mascara;
+        while (tabla[i] != NINGUN_PRODUCTO) i = (i + 1) & mascara;
+        tabla[i] = producto;
+    }
+}
+
+/*---------------+
+ | Constructores |
+ +---------------*/
+
+Catalogo::Catalogo()
+    : tabla(CAPACIDAD_MINIMA, NINGUN_PRODUCTO), nombres(1, ""),
+      dispersiones(1, 0), num_productos(0), bajas(false),
+      en_orden(1, false) {}
+
+/*------------------+
+ | Métodos públicos |
+ +------------------*/
+
+Producto Catalogo::alta(const IdProducto &id_producto) {
+    assert(not id_producto.empty());
+    size_t h = dispersion(id_producto);
+    int i = casilla(id_producto, h);
+    assert(tabla[i] == NINGUN_PRODUCTO); // No estaba en el catálogo
+    Producto producto;
+    if (libres.empty()) {
+        producto = nombres.size();
+        nombres.push_back(id_producto);
+        dispersiones.push_back(h);
+        en_orden.push_back(false);
+    } else {
+        producto = libres.back();
+        libres.pop_back();
+        nombres[producto] = id_producto;
+        dispersiones[producto] = h;
+    }
+    tabla[i] = producto;
+    ++num_productos;
+    if (2 * num_productos > tabla.size()) redispersar(2 * tabla.size());
+    altas.push_back(producto);
+    return producto;
+}
+
+void Catalogo::baja(Producto producto) {
+    assert(NINGUN_PRODUCTO < producto and producto < nombres.size());
+    size_t mascara = tabla.size() - 1;
+    size_t i = casilla(nombres[producto], dispersiones[producto]);
+    assert(tabla[i] == producto);
+    // Vacía la casilla y desplaza hacia ella los productos siguientes de la
+    // racha que no pueden quedar separados de su casilla inicial
+    tabla[i] = NINGUN_PRODUCTO;
+    for (size_t j = (i + 1) & mascara; tabla[j] != NINGUN_PRODUCTO;
+         j = (j + 1) & mascara) {
+        size_t inicial = dispersiones[tabla[j]] & mascara;
+        if (((j - inicial) & mascara) >= ((j - i) & mascara)) {
+            tabla[i] = tabla[j];
+            tabla[j] = NINGUN_PRODUCTO;
+            i = j;
+        }
+    }
+    nombres[producto].clear();
+    libres.push_back(producto);
+    --num_productos;
+    if (en_orden[producto]) {
+        en_orden[producto] = false;
+        bajas = true;
+    }
+}
+
+/*-------------+
+ | Consultores |
+ +-------------*/
+
+Producto Catalogo::codigo(const IdProducto &id_producto) const {
+    return tabla[casilla(id_producto, dispersion(id_producto))];
+}
+
+bool Catalogo::existe(Producto producto) const {
+    assert(0 <= producto and producto < nombres.size());
+    return not nombres[producto].empty();
+}
+
+const IdProducto &Catalogo::nombre(Producto producto) const {
+    assert(NINGUN_PRODUCTO < producto and producto < nombres.size());
+    assert(not nombres[producto].empty());
+    return nombres[producto];
+}
+
+int Catalogo::max_codigo() const {
+    return nombres.size();
+}
+
+bool Catalogo::menor(Producto a, Producto b) const {
+    return nombre(a) < nombre(b);
+}
+
+void Catalogo::contar_comparaciones(long long n) const {
+    num_comparaciones.valor.fetch_add(n, memory_order_relaxed);
+}
+
+long long Catalogo::comparaciones() const {
+    return num_comparaciones.valor.load(memory_order_relaxed);
+}
+
+/*-----+
+ | I/O |
+ +-----*/
+
+void Catalogo::guardar(ostream &os) const {
+    escribir_binario(os, int(nombres.size()));
+    for (int producto = 1; producto < nombres.size(); ++producto) {
+        escribir_binario(os, int(nombres[producto].size()));
+        escribir_binario(os, nombres[producto].data(), nombres[producto].size());
+    }
+}
+
+bool Catalogo::cargar(LectorBinario &lector) {
+    int num_codigos;
+    // Cada código ocupa al menos su longitud: no se reserva de más
+    if (not lector.leer(num_codigos) or num_codigos < 1 or
+        num_codigos - 1 > lector.restantes() / sizeof(int))
+        return false;
+    Catalogo nuevo;
+    nuevo.nombres.resize(num_codigos);
+    nuevo.dispersiones.resize(num_codigos, 0);
+    nuevo.en_orden.resize(num_codigos, false);
+    for (int producto = 1; producto < num_codigos; ++producto) {
+        int longitud;
+        if (not lector.leer(longitud) or longitud < 0 or
+            longitud > lector.restantes())
+            return false;
+        IdProducto &nombre = nuevo.nombres[producto];
+        nombre.resize(longitud);
+        if (not lector.leer(&nombre[0], longitud)) return false;
+        if (nombre.empty()) {
+            nuevo.libres.push_back(producto);
+        } else {
+            nuevo.dispersiones[producto] = dispersion(nombre);
+            nuevo.altas.push_back(producto);
+            ++nuevo.num_productos;
+        }
+    }
+    int capacidad = CAPACIDAD_MINIMA;
+    while (capacidad < 2 * nuevo.num_productos) capacidad *= 2;
+    nuevo.redispersar(capacidad);
+    for (int producto = 1; producto < num_codigos; ++producto) {
+        const IdProducto &nombre = nuevo.nombres[producto];
+        if (not nombre.empty() and
+            nuevo.tabla[nuevo.casilla(nombre, nuevo.dispersiones[producto])] !=
+                producto)
+            return false; // Identificador repetido
+    }
+    // Se reutilizarán primero los códigos más bajos
+    reverse(nuevo.libres.begin(), nuevo.libres.end());
+    nuevo.num_comparaciones = num_comparaciones;
+    *this = move(nuevo);
+    return true;
+}
+
+/*-------+
+ | Orden |
+ +-------*/
+
+const vector<Producto> &Catalogo::ordenados() const {
+    if (bajas) {
+        orden.erase(remove_if(orden.begin(), orden.end(),
+                              [this](Producto p) { return not en_orden[p]; }),
+                    orden.end());
+        bajas = false;
+    }
+    if (altas.empty()) return orden;
+
+    // Las altas que siguen en el catálogo, ordenadas y sin repetir
+    vector<Producto> nuevos;
+    for (Producto producto : altas) {
+        if (existe(producto) and not en_orden[producto]) {
+            en_orden[producto] = true;
+            nuevos.push_back(producto);
+        }
+    }
+    altas.clear();
+    auto comparar = [this](Producto a, Producto b) {
+        return nombres[a] < nombres[b];
+    };
+    sort(nuevos.begin(), nuevos.end(), comparar);
+    vector<Producto> fusion(orden.size() + nuevos.size());
+    merge(orden.begin(), orden.end(), nuevos.begin(), nuevos.end(),
+          fusion.begin(), comparar);
+    orden.swap(fusion);
+    return orden;
+}
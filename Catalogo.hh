@@ -0,0 +1,326 @@
+/** @file
+ * Archivo que define Catalogo y el código interno de producto, @ref Producto.
+ */
+
+#ifndef CATALOGO_HH
+#define CATALOGO_HH
+
+#include "Binario.hh"
+#include "aux.hh"
+#ifndef NO_DIAGRAM
+#    include <atomic>
+#    include <ostream>
+#    include <vector>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Código interno de un producto.
+ *
+ * Las estanterías guardan códigos en lugar de @ref IdProducto: ocupan menos
+ * memoria y se comparan en tiempo constante. El código @ref NINGUN_PRODUCTO
+ * indica una posición vacía.
+ */
+typedef int Producto;
+
+/// Código reservado para las posiciones vacías.
+const Producto NINGUN_PRODUCTO = 0;
+
+/** Catálogo de productos.
+ *
+ * Asigna a cada @ref IdProducto dado de alta un código (@ref Producto) único
+ * mientras el producto exista. Los identificadores sólo se vuelven a usar en la
+ * entrada/salida.
+ */
+class Catalogo {
+private:
+    /** Tabla de dispersión (con direccionamiento abierto y sondeo lineal)
+     * [identificador &rarr; código].
+     *
+     * Cada casilla contiene un código o @ref NINGUN_PRODUCTO si está vacía;
+     * un producto está en la primera casilla vacía u ocupada por él a partir
+     * de <tt>dispersiones[producto] & (tabla.size() - 1)</tt>. Al dar de baja
+     * un producto se desplazan hacia atrás los siguientes de su racha, así
+     * que no hace falta marcar las casillas borradas.
+     *
+     * @invariant
+     * <tt>tabla.size()</tt> es una potencia de 2 y al menos el doble del
+     * número de productos; <tt>nombres[c] == id</tt> para cada código @c c
+     * de la tabla, siendo @c id el identificador que lleva a su casilla.
+     */
+    vector<Producto> tabla;
+
+    /** Nombre de cada código.
+     *
+     * @invariant
+     * <tt>nombres[0] == ""</tt>; los códigos libres tienen el nombre vacío.
+     */
+    vector<IdProducto> nombres;
+
+    /// Valor de dispersión del nombre de cada código.
+    vector<size_t> dispersiones;
+
+    /// Códigos dados de baja, que se reutilizarán en las siguientes altas.
+    vector<Producto> libres;
+
+    /// Número de productos del catálogo.
+    int num_productos;
+
+    /** Códigos de los productos del catálogo por orden alfabético.
+     *
+     * Es una caché que ordenados() pone al día cuando se ha dado de alta o de
+     * baja algún producto desde la última vez: quita las bajas y fusiona las
+     * altas (ordenadas aparte), sin volver a ordenar todo el catálogo.
+     */
+    mutable vector<Producto> orden;
+
+    /** Códigos dados de alta desde la última actualización de @ref orden (un
+     * código dado de baja y reutilizado puede aparecer más de una vez).
+     */
+    mutable vector<Producto> altas;
+
+    /// Indica si se ha dado de baja algún producto de @ref orden.
+    mutable bool bajas;
+
+    /// Indica, para cada código, si está en @ref orden.
+    mutable vector<bool> en_orden;
+
+    /** Contador de comparaciones.
+     *
+     * Es atómico porque se pueden ordenar salas distintas a la vez (ver
+     * EjecutorParalelo); se define aparte para que el catálogo se pueda
+     * seguir copiando.
+     */
+    struct Contador {
+        /// Valor del contador.
+        atomic<long long> valor;
+
+        /// Crea un contador a 0.
+        Contador() : valor(0) {}
+
+        /// Copia el valor de otro contador.
+        Contador(const Contador &otro) : valor(otro.valor.load()) {}
+
+        /// Copia el valor de otro contador.
+        Contador &operator=(const Contador &otro) {
+            valor = otro.valor.load();
+            return *this;
+        }
+    };
+
+    /// Número de comparaciones de identificadores contadas.
+    mutable Contador num_comparaciones;
+
+    /** Busca la casilla de un identificador en @ref tabla.
+     *
+     * @param id_producto
+     * Identificador del producto.
+     *
+     * @param h
+     * Valor de dispersión de @c id_producto.
+     *
+     * @returns
+     * La casilla que ocupa @c id_producto, o la casilla vacía en la que se
+     * insertaría si no está en el catálogo.
+     *
+     * @cost
+     * Constante (esperado), más la comparación de los identificadores
+     */
+    int casilla(const IdProducto &id_producto, size_t h) const;
+
+    /** Reconstruye @ref tabla con otra capacidad.
+     *
+     * @param capacidad
+     * Nueva capacidad: una potencia de 2 mayor que el doble del número de
+     * productos.
+     *
+     * @cost
+     * Lineal en @c capacidad y en max_codigo()
+     */
+    void redispersar(int capacidad);
+
+public:
+    /** Crea un catálogo vacío.
+     *
+     * @cost
+     * Constante
+     */
+    Catalogo();
+
+    /** Da de alta un producto.
+     *
+     * @param id_producto
+     * Identificador del producto.
+     *
+     * @returns
+     * El código asignado al producto.
+     *
+     * @pre
+     * @c id_producto no está en el catálogo.
+     *
+     * @post
+     * @c id_producto está en el catálogo, con un código distinto de @ref
+     * NINGUN_PRODUCTO y menor que max_codigo().
+     *
+     * @cost
+     * Lineal en la longitud de @c id_producto (esperado y amortizado)
+     */
+    Producto alta(const IdProducto &id_producto);
+
+    /** Da de baja un producto.
+     *
+     * @param producto
+     * Código del producto.
+     *
+     * @pre
+     * @c producto es el código de un producto del catálogo, y no queda ningún
+     * ítem suyo en ninguna estantería.
+     *
+     * @post
+     * El producto ya no está en el catálogo; su código se podrá reutilizar.
+     *
+     * @cost
+     * Constante (esperado)
+     */
+    void baja(Producto producto);
+
+    /** Consulta el código de un producto.
+     *
+     * @param id_producto
+     * Identificador del producto.
+     *
+     * @returns
+     * El código de @c id_producto, o @ref NINGUN_PRODUCTO si no está en el
+     * catálogo.
+     *
+     * @cost
+     * Lineal en la longitud de @c id_producto (esperado)
+     */
+    Producto codigo(const IdProducto &id_producto) const;
+
+    /** Indica si un código pertenece a un producto del catálogo.
+     *
+     * @param producto
+     * Código, entre 0 y max_codigo() (no incluido).
+     *
+     * @cost
+     * Constante
+     */
+    bool existe(Producto producto) const;
+
+    /** Consulta el identificador de un código.
+     *
+     * @param producto
+     * Código del producto.
+     *
+     * @returns
+     * El identificador del producto.
+     *
+     * @pre
+     * @c producto es el código de un producto del catálogo.
+     *
+     * @cost
+     * Constante
+     */
+    const IdProducto &nombre(Producto producto) const;
+
+    /** Cota superior de los códigos asignados.
+     *
+     * @returns
+     * Un valor mayor que todos los códigos asignados hasta ahora. Sirve para
+     * dimensionar vectores indexados por @ref Producto.
+     *
+     * @cost
+     * Constante
+     */
+    int max_codigo() const;
+
+    /** Compara alfabéticamente los identificadores de dos códigos.
+     *
+     * @param a, b
+     * Códigos de los productos.
+     *
+     * @returns
+     * Si el identificador de @c a es anterior al de @c b.
+     *
+     * @pre
+     * @c a y @c b son códigos de productos del catálogo.
+     *
+     * @cost
+     * Lineal en la longitud de los identificadores
+     */
+    bool menor(Producto a, Producto b) const;
+
+    /** Cuenta comparaciones hechas con menor() (ver comparaciones()).
+     *
+     * Quien ordena con menor() cuenta las comparaciones por su cuenta y las
+     * suma aquí de una vez, de forma que ordenar desde varios hilos no
+     * compite por el contador en cada comparación.
+     *
+     * @param n
+     * Número de comparaciones.
+     *
+     * @cost
+     * Constante
+     */
+    void contar_comparaciones(long long n) const;
+
+    /** Número de comparaciones contadas (ver contar_comparaciones()) desde
+     * que se creó el catálogo.
+     *
+     * @cost
+     * Constante
+     */
+    long long comparaciones() const;
+
+    /** Guarda el catálogo en binario.
+     *
+     * Escribe max_codigo() y el identificador de cada código (vacío si el
+     * código está libre), de forma que al cargarlo cada producto conserva
+     * su código.
+     *
+     * @param os
+     * Stream de salida.
+     *
+     * @cost
+     * Lineal en max_codigo() y en la longitud de los identificadores
+     */
+    void guardar(ostream &os) const;
+
+    /** Carga un catálogo guardado con guardar().
+     *
+     * @param lector
+     * Lector del bloque con el catálogo.
+     *
+     * @retval true
+     * Se ha cargado el catálogo, que sustituye al anterior.
+     *
+     * @retval false
+     * El bloque no contiene un catálogo válido. El objeto no ha sido
+     * modificado.
+     *
+     * @cost
+     * Lineal en max_codigo() y en la longitud de los identificadores
+     * (esperado)
+     */
+    bool cargar(LectorBinario &lector);
+
+    /** Códigos de los productos del catálogo por orden alfabético de sus
+     * identificadores.
+     *
+     * @returns
+     * Una referencia válida hasta la siguiente alta o baja.
+     *
+     * @post
+     * La caché está al día: hasta la siguiente alta o baja, ordenados() no
+     * modifica el catálogo (y se puede llamar desde varios hilos a la vez).
+     *
+     * @cost
+     * Constante si no se ha dado de alta ni de baja ningún producto desde la
+     * última llamada; si no, lineal en el número de productos más
+     * linearítmico en el número de altas
+     */
+    const vector<Producto> &ordenados() const;
+};
+
+#endif // CATALOGO_HH
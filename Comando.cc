@@ -0,0 +1,370 @@
+/** @file
+ * Implementación de las operaciones sobre @ref Comando.
+ */
+#include "Comando.hh"
+#ifndef NO_DIAGRAM
+#    include <algorithm>
+#    include <cassert>
+#    include <cstring>
+#    include <vector>
+#endif
+
+/*-----------+
+ | Ejecutores |
+ +-----------*/
+
+// Cada instrucción tiene una función que la ejecuta sobre el almacén.
+
+static void ej_poner_prod(Almacen &almacen, const Comando &comando,
+                          Resultado &resultado, ostream &) {
+    resultado.valor = almacen.poner_prod(comando.id_producto);
+}
+
+static void ej_quitar_prod(Almacen &almacen, const Comando &comando,
+                           Resultado &resultado, ostream &) {
+    resultado.valor = almacen.quitar_prod(comando.id_producto);
+}
+
+static void ej_poner_items(Almacen &almacen, const Comando &comando,
+                           Resultado &resultado, ostream &) {
+    resultado.valor = almacen.poner_items(comando.id_sala, comando.id_producto,
+                                          comando.cantidad);
+}
+
+static void ej_quitar_items(Almacen &almacen, const Comando &comando,
+                            Resultado &resultado, ostream &) {
+    resultado.valor = almacen.quitar_items(comando.id_sala,
+                                           comando.id_producto,
+                                           comando.cantidad);
+}
+
+static void ej_distribuir(Almacen &almacen, const Comando &comando,
+                          Resultado &resultado, ostream &) {
+    resultado.valor = almacen.distribuir(comando.id_producto, comando.cantidad);
+}
+
+static void ej_compactar(Almacen &almacen, const Comando &comando,
+                         Resultado &, ostream &) {
+    almacen.compactar(comando.id_sala);
+}
+
+static void ej_reorganizar(Almacen &almacen, const Comando &comando,
+                           Resultado &, ostream &) {
+    almacen.reorganizar(comando.id_sala);
+}
+
+static void ej_redimensionar(Almacen &almacen, const Comando &comando,
+                             Resultado &resultado, ostream &) {
+    resultado.valor = almacen.redimensionar(comando.id_sala, comando.f,
+                                            comando.c);
+}
+
+static void ej_lote(Almacen &almacen, const Comando &comando,
+                    Resultado &resultado, ostream &) {
+    resultado.valores = almacen.aplicar_lote(comando.operaciones);
+}
+
+static void ej_inventario(Almacen &almacen, const Comando &,
+                          Resultado &, ostream &os) {
+    almacen.inventario(os);
+}
+
+static void ej_escribir(Almacen &almacen, const Comando &comando,
+                        Resultado &, ostream &os) {
+    almacen.escribir(comando.id_sala, os);
+}
+
+static void ej_consultar_pos(Almacen &almacen, const Comando &comando,
+                             Resultado &resultado, ostream &) {
+    resultado.id_producto = almacen.consultar_pos(comando.id_sala, comando.f,
+                                                  comando.c);
+}
+
+static void ej_consultar_prod(Almacen &almacen, const Comando &comando,
+                              Resultado &resultado, ostream &) {
+    resultado.valor = almacen.consultar_prod(comando.id_producto);
+}
+
+static void ej_ubicar_prod(Almacen &almacen, const Comando &comando,
+                           Resultado &resultado, ostream &os) {
+    resultado.valor = almacen.ubicar_prod(comando.id_producto, os);
+}
+
+static void ej_guardar(Almacen &almacen, const Comando &comando,
+                       Resultado &resultado, ostream &) {
+    resultado.valor = almacen.guardar(comando.fichero);
+}
+
+static void ej_cargar(Almacen &almacen, const Comando &comando,
+                      Resultado &resultado, ostream &) {
+    resultado.valor = almacen.cargar(comando.fichero);
+}
+
+static void ej_desconocido(Almacen &, const Comando &, Resultado &resultado,
+                           ostream &) {
+    resultado.valor = 0; // Siempre es un error
+}
+
+/*-----------------------+
+ | Tabla de instrucciones |
+ +-----------------------*/
+
+/// Descripción de una instrucción.
+struct Instruccion {
+    /// Nombre de la instrucción.
+    const char *nombre;
+    /// Argumentos (ver argumentos_comando()).
+    const char *argumentos;
+    /// Función que ejecuta la instrucción.
+    void (*ejecutar)(Almacen &, const Comando &, Resultado &, ostream &);
+    /// Forma de escribir el resultado.
+    TipoResultado resultado;
+};
+
+/// Instrucciones, en el orden de @ref TipoComando.
+static const Instruccion INSTRUCCIONES[] = {
+    {"poner_prod", "p", ej_poner_prod, ERROR_SI_FALLA},
+    {"quitar_prod", "p", ej_quitar_prod, ERROR_SI_FALLA},
+    {"poner_items", "spn", ej_poner_items, CANTIDAD},
+    {"quitar_items", "spn", ej_quitar_items, CANTIDAD},
+    {"distribuir", "pn", ej_distribuir, CANTIDAD},
+    {"compactar", "s", ej_compactar, NINGUNO},
+    {"reorganizar", "s", ej_reorganizar, NINGUNO},
+    {"redimensionar", "sfc", ej_redimensionar, ERROR_SI_FALLA},
+    {"lote", "l", ej_lote, CANTIDADES},
+    {"inventario", "", ej_inventario, NINGUNO},
+    {"escribir", "s", ej_escribir, NINGUNO},
+    {"consultar_pos", "sfc", ej_consultar_pos, PRODUCTO},
+    {"consultar_prod", "p", ej_consultar_prod, CANTIDAD},
+    {"ubicar_prod", "p", ej_ubicar_prod, ERROR_SI_FALLA},
+    {"estadisticas", "", NULL, NINGUNO},
+    {"guardar", "a", ej_guardar, ERROR_SI_FALLA},
+    {"cargar", "a", ej_cargar, ERROR_SI_FALLA},
+    {"punto_control", "", NULL, ERROR_SI_FALLA},
+    {"fin", "", NULL, NINGUNO},
+    {NULL, "", ej_desconocido, ERROR_SI_FALLA},
+};
+
+/// Tamaño de la tabla de dispersión de instrucciones (potencia de 2).
+static const int TAM_HASH = 64;
+
+/** Función de dispersión de los nombres de instrucción.
+ *
+ * Se ha escogido para que no haya colisiones entre los nombres de @ref
+ * INSTRUCCIONES (se comprueba al construir el índice), de forma que cada
+ * nombre se identifica con una sola comparación de cadenas.
+ */
+static int hash_instruccion(const char *nombre, int longitud) {
+    unsigned char primero = nombre[0], ultimo = nombre[longitud - 1];
+    return (longitud + 3 * primero + 9 * ultimo) & (TAM_HASH - 1);
+}
+
+/// Índice [hash &rarr; @ref TipoComando] (o -1 si no hay ninguno).
+static vector<int> construir_indice() {
+    vector<int> indice(TAM_HASH, -1);
+    for (int tipo = 0; tipo < DESCONOCIDO; ++tipo) {
+        const char *nombre = INSTRUCCIONES[tipo].nombre;
+        int h = hash_instruccion(nombre, strlen(nombre));
+        assert(indice[h] == -1); // Sin colisiones
+        indice[h] = tipo;
+    }
+    return indice;
+}
+
+/// Tipo de la instrucción con nombre @c token.
+static TipoComando tipo_comando(const Token &token) {
+    static const vector<int> indice = construir_indice();
+    int tipo = indice[hash_instruccion(token.datos, token.longitud)];
+    if (tipo == -1 or token != INSTRUCCIONES[tipo].nombre) return DESCONOCIDO;
+    return TipoComando(tipo);
+}
+
+/** Operaciones de un @c lote para las que se reserva memoria de entrada: el
+ * resto se añaden a medida que se leen, de forma que un número de
+ * operaciones exagerado no reserva más memoria que la que ocupa la entrada.
+ */
+static const int MAX_RESERVA_LOTE = 1 << 12;
+
+/// Lee una palabra y la añade a @c leido, tras un espacio.
+static bool leer_palabra(Lector &lector, Token &token, string &leido) {
+    if (not lector.leer(token)) return false;
+    leido.append(1, ' ').append(token.datos, token.longitud);
+    return true;
+}
+
+/** Lee la lista de operaciones de un @c lote.
+ *
+ * @param[out] leido
+ * Se le añaden las palabras leídas (para el eco de un lote mal formado).
+ *
+ * @retval false
+ * Falta algún argumento o alguna operación no es @c poner_items ni
+ * @c quitar_items.
+ */
+static bool leer_operaciones(Lector &lector, vector<OperacionLote> &ops,
+                             string &leido) {
+    Token token;
+    int n;
+    if (not leer_palabra(lector, token, leido) or not token.entero(n) or
+        n < 0)
+        return false;
+    ops.clear();
+    ops.reserve(min(n, MAX_RESERVA_LOTE));
+    OperacionLote op;
+    for (int i = 0; i < n; ++i) {
+        if (not leer_palabra(lector, token, leido)) return false;
+        TipoComando tipo = tipo_comando(token);
+        if (tipo != PONER_ITEMS and tipo != QUITAR_ITEMS) return false;
+        op.poner = tipo == PONER_ITEMS;
+        if (not leer_palabra(lector, token, leido) or
+            not token.entero(op.id_sala) or
+            not leer_palabra(lector, token, leido))
+            return false;
+        op.id_producto.assign(token.datos, token.longitud);
+        if (not leer_palabra(lector, token, leido) or
+            not token.entero(op.cantidad))
+            return false;
+        ops.push_back(op);
+    }
+    return true;
+}
+
+/*-----------+
+ | Funciones |
+ +-----------*/
+
+bool leer_comando(Lector &lector, Comando &comando) {
+    Token token;
+    if (not lector.leer(token)) return false;
+    comando.tipo = tipo_comando(token);
+    if (comando.tipo == DESCONOCIDO) {
+        comando.nombre.assign(token.datos, token.longitud);
+    }
+    const char *argumentos = INSTRUCCIONES[comando.tipo].argumentos;
+    bool ok = true;
+    for (const char *a = argumentos; ok and *a != '\0'; ++a) {
+        switch (*a) {
+            case 's': ok = lector.leer(comando.id_sala); break;
+            case 'p': ok = lector.leer(comando.id_producto); break;
+            case 'n': ok = lector.leer(comando.cantidad); break;
+            case 'f': ok = lector.leer(comando.f); break;
+            case 'c': ok = lector.leer(comando.c); break;
+            case 'a': ok = lector.leer(comando.fichero); break;
+            case 'l':
+                // Un lote mal formado es una instrucción que falla, como las
+                // desconocidas, con lo que se ha leído como nombre
+                comando.nombre = nombre_comando(LOTE);
+                if (not leer_operaciones(lector, comando.operaciones,
+                                         comando.nombre))
+                    comando.tipo = DESCONOCIDO;
+                break;
+        }
+    }
+    return ok;
+}
+
+void ejecutar(Almacen &almacen, const Comando &comando, Resultado &resultado,
+              ostream &os) {
+    assert(INSTRUCCIONES[comando.tipo].ejecutar != NULL);
+    INSTRUCCIONES[comando.tipo].ejecutar(almacen, comando, resultado, os);
+}
+
+bool comando_valido(const Almacen &almacen, const Comando &comando) {
+    for (const char *a = INSTRUCCIONES[comando.tipo].argumentos; *a != '\0';
+         ++a) {
+        switch (*a) {
+            case 's':
+                if (not almacen.sala_valida(comando.id_sala)) return false;
+                break;
+            case 'n':
+                if (comando.cantidad < 0) return false;
+                break;
+            case 'f':
+                // Posición en consultar_pos, dimensión en redimensionar
+                if (comando.tipo == CONSULTAR_POS) {
+                    if (not almacen.posicion_valida(comando.id_sala,
+                                                    comando.f, comando.c))
+                        return false;
+                } else if (comando.f <= 0 or comando.c <= 0) {
+                    return false;
+                }
+                break;
+            case 'l':
+                for (const OperacionLote &op : comando.operaciones) {
+                    if (not almacen.sala_valida(op.id_sala) or
+                        op.cantidad < 0)
+                        return false;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+const char *nombre_comando(TipoComando tipo) {
+    if (tipo == DESCONOCIDO) return "desconocida";
+    return INSTRUCCIONES[tipo].nombre;
+}
+
+const char *argumentos_comando(TipoComando tipo) {
+    return INSTRUCCIONES[tipo].argumentos;
+}
+
+TipoResultado tipo_resultado(TipoComando tipo) {
+    return INSTRUCCIONES[tipo].resultado;
+}
+
+void escribir_eco(ostream &os, const Comando &comando) {
+    const Instruccion &instruccion = INSTRUCCIONES[comando.tipo];
+    if (comando.tipo == DESCONOCIDO) {
+        os << comando.nombre;
+    } else {
+        os << instruccion.nombre;
+    }
+    for (const char *a = instruccion.argumentos; *a != '\0'; ++a) {
+        os << ' ';
+        switch (*a) {
+            case 's': os << comando.id_sala; break;
+            case 'p': os << comando.id_producto; break;
+            case 'n': os << comando.cantidad; break;
+            case 'f': os << comando.f; break;
+            case 'c': os << comando.c; break;
+            case 'a': os << comando.fichero; break;
+            case 'l':
+                os << comando.operaciones.size();
+                for (const OperacionLote &op : comando.operaciones) {
+                    os << ' ' << nombre_comando(op.poner ? PONER_ITEMS
+                                                         : QUITAR_ITEMS)
+                       << ' ' << op.id_sala << ' ' << op.id_producto << ' '
+                       << op.cantidad;
+                }
+                break;
+        }
+    }
+    os << '\n';
+}
+
+void escribir_resultado(ostream &os, const Comando &comando,
+                        const Resultado &resultado) {
+    switch (INSTRUCCIONES[comando.tipo].resultado) {
+        case NINGUNO: break;
+        case ERROR_SI_FALLA:
+            if (resultado.valor == 0) os << "  error" << '\n';
+            break;
+        case CANTIDAD:
+            if (resultado.valor == -1)
+                os << "  error" << '\n';
+            else
+                os << "  " << resultado.valor << '\n';
+            break;
+        case PRODUCTO: os << "  " << resultado.id_producto << '\n'; break;
+        case CANTIDADES:
+            for (int valor : resultado.valores) {
+                if (valor == -1)
+                    os << "  error" << '\n';
+                else
+                    os << "  " << valor << '\n';
+            }
+            break;
+    }
+}
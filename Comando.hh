@@ -0,0 +1,240 @@
+/** @file
+ * Archivo que define @ref Comando, @ref Resultado y las operaciones para
+ * leerlos, ejecutarlos y escribirlos.
+ *
+ * El procesado de cada instrucción se separa en tres pasos independientes:
+ * leer_comando() (entrada &rarr; @ref Comando), ejecutar() (@ref Comando
+ * &rarr; @ref Resultado, sobre un Almacen) y escribir_eco() /
+ * escribir_resultado() (salida).
+ */
+
+#ifndef COMANDO_HH
+#define COMANDO_HH
+
+#include "Almacen.hh"
+#include "Lector.hh"
+#include "Sala.hh"
+#include "aux.hh"
+#ifndef NO_DIAGRAM
+#    include <ostream>
+#    include <vector>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/// Tipo de instrucción.
+enum TipoComando {
+    PONER_PROD,
+    QUITAR_PROD,
+    PONER_ITEMS,
+    QUITAR_ITEMS,
+    DISTRIBUIR,
+    COMPACTAR,
+    REORGANIZAR,
+    REDIMENSIONAR,
+    /// Lote de @c poner_items y @c quitar_items (ver Almacen::aplicar_lote).
+    LOTE,
+    INVENTARIO,
+    ESCRIBIR,
+    CONSULTAR_POS,
+    CONSULTAR_PROD,
+    UBICAR_PROD,
+    /// Escribe las estadísticas (ver Estadisticas); lo ejecuta main().
+    ESTADISTICAS,
+    GUARDAR,
+    CARGAR,
+    /// Hace un punto de control del diario (ver Diario); lo ejecuta main().
+    PUNTO_CONTROL,
+    FIN,
+    /// Instrucción no reconocida (se responde con un error).
+    DESCONOCIDO
+};
+
+/// Forma de escribir el resultado de una instrucción.
+enum TipoResultado {
+    /// No se escribe nada (o la instrucción ya ha escrito un listado).
+    NINGUNO,
+    /// @c "  error" si @ref Resultado::valor es 0.
+    ERROR_SI_FALLA,
+    /// @ref Resultado::valor, o @c "  error" si es -1.
+    CANTIDAD,
+    /// @ref Resultado::id_producto.
+    PRODUCTO,
+    /// Cada valor de @ref Resultado::valores, como en @ref CANTIDAD.
+    CANTIDADES
+};
+
+/** Instrucción leída, con sus argumentos.
+ *
+ * Sólo tienen valor los campos que usa la instrucción @ref tipo.
+ */
+struct Comando {
+    /// Tipo de instrucción.
+    TipoComando tipo;
+    /// Sala sobre la que se opera.
+    IdSala id_sala;
+    /// Producto sobre el que se opera.
+    IdProducto id_producto;
+    /// Cantidad de ítems.
+    int cantidad;
+    /// Fila (o número de filas, en @c redimensionar).
+    int f;
+    /// Columna (o número de columnas, en @c redimensionar).
+    int c;
+    /// Nombre de la instrucción, si es @ref DESCONOCIDO.
+    string nombre;
+    /// Fichero (en @c guardar y @c cargar).
+    string fichero;
+    /// Operaciones (en @c lote).
+    vector<OperacionLote> operaciones;
+};
+
+/** Resultado de ejecutar un @ref Comando.
+ *
+ * Sólo tienen valor los campos que usa la instrucción.
+ */
+struct Resultado {
+    /** Valor devuelto por el almacén: cantidad de ítems, -1 si hay un error
+     * o (en instrucciones que no devuelven ninguna cantidad) 1 si la
+     * operación se ha hecho y 0 si no.
+     */
+    int valor;
+    /// Producto (en @c consultar_pos).
+    IdProducto id_producto;
+    /// Valor devuelto por cada operación (en @c lote).
+    vector<int> valores;
+};
+
+/** Lee una instrucción.
+ *
+ * @param lector
+ * Lector de la entrada.
+ *
+ * @param[out] comando
+ * Instrucción leída.
+ *
+ * @retval true
+ * Se ha leído una instrucción (que puede ser @ref FIN o @ref DESCONOCIDO).
+ * Un @c lote mal formado (p.ej. con una operación que no es
+ * @c poner_items ni @c quitar_items) se lee como una instrucción
+ * @ref DESCONOCIDO, que falla, con las palabras leídas como nombre; la
+ * lectura sigue tras la última de ellas.
+ *
+ * @retval false
+ * No quedan instrucciones en la entrada.
+ *
+ * @cost
+ * Lineal en la longitud de la instrucción
+ */
+bool leer_comando(Lector &lector, Comando &comando);
+
+/** Ejecuta una instrucción.
+ *
+ * @param almacen
+ * Almacén sobre el que se ejecuta.
+ *
+ * @param comando
+ * Instrucción a ejecutar.
+ *
+ * @param[out] resultado
+ * Resultado de la instrucción.
+ *
+ * @param os
+ * Stream en el que se escriben los listados (@c escribir e @c inventario),
+ * que dependen del estado del almacén en el momento de ejecutarlas.
+ *
+ * @pre
+ * @c comando no es @ref FIN, @ref ESTADISTICAS ni @ref PUNTO_CONTROL.
+ *
+ * @cost
+ * El de la operación correspondiente de Almacen
+ */
+void ejecutar(Almacen &almacen, const Comando &comando, Resultado &resultado,
+              ostream &os);
+
+/** Comprueba las precondiciones de ejecutar() que dependen de los
+ * argumentos: que las salas y posiciones existan en el almacén, que las
+ * cantidades no sean negativas y que las dimensiones sean positivas.
+ *
+ * main() no las comprueba (la entrada las cumple); quien recibe
+ * instrucciones de otros (ver Servidor) sí.
+ *
+ * @param almacen
+ * Almacén sobre el que se ejecutaría la instrucción, en su estado actual.
+ *
+ * @param comando
+ * Instrucción.
+ *
+ * @cost
+ * Constante, o lineal en el número de operaciones de un @c lote
+ */
+bool comando_valido(const Almacen &almacen, const Comando &comando);
+
+/** Nombre de un tipo de instrucción.
+ *
+ * @param tipo
+ * Tipo de instrucción.
+ *
+ * @returns
+ * El nombre de la instrucción en la entrada, o @c "desconocida" si @c tipo es
+ * @ref DESCONOCIDO.
+ *
+ * @cost
+ * Constante
+ */
+const char *nombre_comando(TipoComando tipo);
+
+/** Argumentos de un tipo de instrucción.
+ *
+ * @param tipo
+ * Tipo de instrucción.
+ *
+ * @returns
+ * Una letra por argumento, en orden: @c s (sala), @c p (producto), @c n
+ * (cantidad), @c f (fila), @c c (columna), @c a (fichero) y @c l (lista de
+ * operaciones: su número y, para cada una, @c poner_items o
+ * @c quitar_items con sus argumentos).
+ *
+ * @cost
+ * Constante
+ */
+const char *argumentos_comando(TipoComando tipo);
+
+/** Forma en que se escribe el resultado de un tipo de instrucción.
+ *
+ * @param tipo
+ * Tipo de instrucción.
+ *
+ * @returns
+ * Qué campos de @ref Resultado usa la instrucción y cómo se escriben.
+ *
+ * @cost
+ * Constante
+ */
+TipoResultado tipo_resultado(TipoComando tipo);
+
+/** Escribe el eco de una instrucción (su nombre y argumentos).
+ *
+ * @param os
+ * Stream de salida.
+ *
+ * @param comando
+ * Instrucción.
+ */
+void escribir_eco(ostream &os, const Comando &comando);
+
+/** Escribe el resultado de una instrucción.
+ *
+ * @param os
+ * Stream de salida.
+ *
+ * @param comando
+ * Instrucción.
+ *
+ * @param resultado
+ * Resultado de ejecutar @c comando.
+ */
+void escribir_resultado(ostream &os, const Comando &comando,
+                        const Resultado &resultado);
+
+#endif // COMANDO_HH
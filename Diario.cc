@@ -0,0 +1,205 @@
+/** @file
+ * Implementación de Diario.
+ */
+#include "Diario.hh"
+#include "Lector.hh"
+#ifndef NO_DIAGRAM
+#    include <cassert>
+#    include <cstdio> // std::rename
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+/// Tamaño del buffer del diario.
+static const int TAM_BUFFER = 1 << 16;
+
+/** Trunca un fichero justo después de su último salto de línea (o a 0 si no
+ * tiene ninguno), de forma que sólo quedan líneas completas.
+ *
+ * @retval false
+ * Ha habido un error de lectura o escritura.
+ */
+static bool descartar_linea_incompleta(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    off_t fin = st.st_size;
+    char bloque[4096];
+    while (fin > 0) {
+        off_t inicio = fin > off_t(sizeof bloque) ? fin - sizeof bloque : 0;
+        ssize_t leido = pread(fd, bloque, fin - inicio, inicio);
+        if (leido != fin - inicio) return false;
+        for (ssize_t i = leido - 1; i >= 0; --i) {
+            if (bloque[i] == '\n') {
+                off_t longitud = inicio + i + 1;
+                return longitud == st.st_size or ftruncate(fd, longitud) == 0;
+            }
+        }
+        fin = inicio;
+    }
+    return st.st_size == 0 or ftruncate(fd, 0) == 0;
+}
+
+/** Escribe un fichero entero de forma atómica: en un fichero temporal que,
+ * una vez sincronizado con el disco, sustituye a @c fichero (y se sincroniza
+ * también el directorio, para que la sustitución sea duradera).
+ */
+static bool escribir_atomico(const string &fichero, const string &contenido) {
+    string temporal = fichero + ".tmp";
+    int fd = open(temporal.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = write(fd, contenido.data(), contenido.size()) ==
+              ssize_t(contenido.size());
+    ok = ok and fsync(fd) == 0;
+    ok = close(fd) == 0 and ok;
+    ok = ok and rename(temporal.c_str(), fichero.c_str()) == 0;
+    if (not ok) unlink(temporal.c_str());
+    return ok and sincronizar_directorio(fichero);
+}
+
+/*------------------+
+ | Métodos privados |
+ +------------------*/
+
+string Diario::fichero(int g, const char *extension) const {
+    return prefijo + '.' + to_string(g) + '.' + extension;
+}
+
+bool Diario::abrir() {
+    assert(fd == -1);
+    string diario = fichero(generacion, "diario");
+    fd = open(diario.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return false;
+    if (not sincronizar_directorio(diario)) { // Puede que se haya creado
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    salida.reset(new Salida(fd, TAM_BUFFER, true));
+    os.rdbuf(salida.get());
+    return true;
+}
+
+void Diario::cerrar() {
+    if (fd == -1) return;
+    confirmar();
+    os.rdbuf(NULL);
+    salida.reset();
+    close(fd);
+    fd = -1;
+}
+
+/*---------------+
+ | Constructores |
+ +---------------*/
+
+Diario::Diario(const string &prefijo, int lote)
+    : prefijo(prefijo), generacion(0), lote(lote), pendientes(0), fd(-1),
+      os(NULL) {
+    assert(lote >= 1);
+}
+
+Diario::~Diario() {
+    cerrar();
+}
+
+/*------------------+
+ | Métodos públicos |
+ +------------------*/
+
+bool Diario::modifica(TipoComando tipo) {
+    switch (tipo) {
+        case PONER_PROD:
+        case QUITAR_PROD:
+        case PONER_ITEMS:
+        case QUITAR_ITEMS:
+        case DISTRIBUIR:
+        case COMPACTAR:
+        case REORGANIZAR:
+        case REDIMENSIONAR:
+        case LOTE: return true;
+        default: return false;
+    }
+}
+
+long long Diario::recuperar(Almacen &almacen) {
+    assert(fd == -1);
+    // Generación vigente
+    generacion = 0;
+    int fd_actual = open((prefijo + ".actual").c_str(), O_RDONLY);
+    if (fd_actual >= 0) {
+        Lector lector(fd_actual);
+        bool ok = lector.leer(generacion) and generacion >= 0;
+        close(fd_actual);
+        if (not ok) return -1;
+    }
+    if (generacion > 0 and not almacen.cargar(fichero(generacion, "snap")))
+        return -1;
+
+    // Instrucciones del diario
+    long long ejecutadas = 0;
+    int fd_diario = open(fichero(generacion, "diario").c_str(), O_RDWR);
+    if (fd_diario >= 0) {
+        bool ok = descartar_linea_incompleta(fd_diario);
+        Lector lector(fd_diario);
+        Comando comando;
+        Resultado resultado;
+        ostream nulo(NULL); // Las instrucciones del diario no escriben nada
+        while (ok and leer_comando(lector, comando)) {
+            if (modifica(comando.tipo)) {
+                ejecutar(almacen, comando, resultado, nulo);
+                ++ejecutadas;
+            }
+        }
+        close(fd_diario);
+        if (not ok) return -1;
+    }
+    if (not abrir()) return -1;
+    return ejecutadas;
+}
+
+void Diario::anotar(const Comando &comando) {
+    assert(fd != -1);
+    if (not modifica(comando.tipo)) return;
+    escribir_eco(os, comando);
+    if (++pendientes >= lote) confirmar();
+}
+
+bool Diario::confirmar() {
+    pendientes = 0;
+    return bool(os.flush());
+}
+
+bool Diario::punto_control(const Almacen &almacen) {
+    assert(fd != -1);
+    if (not confirmar()) return false;
+    int nueva = generacion + 1;
+    if (not almacen.guardar(fichero(nueva, "snap"))) return false;
+    string diario = fichero(nueva, "diario");
+    int fd_nuevo =
+        open(diario.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd_nuevo < 0) return false;
+    // El diario nuevo tiene que estar en el directorio antes de que
+    // prefijo.actual lo haga vigente
+    if (fsync(fd_nuevo) != 0 or not sincronizar_directorio(diario) or
+        not escribir_atomico(prefijo + ".actual", to_string(nueva) + '\n')) {
+        close(fd_nuevo);
+        unlink(diario.c_str());
+        return false;
+    }
+
+    // La generación nueva ya es la vigente
+    cerrar();
+    unlink(fichero(generacion, "snap").c_str());
+    unlink(fichero(generacion, "diario").c_str());
+    sincronizar_directorio(diario); // Si falla, sólo sobran ficheros viejos
+    generacion = nueva;
+    fd = fd_nuevo;
+    salida.reset(new Salida(fd, TAM_BUFFER, true));
+    os.rdbuf(salida.get());
+    return true;
+}
+
+ostream &Diario::flujo() {
+    return os;
+}
@@ -0,0 +1,153 @@
+/** @file
+ * Archivo que define Diario.
+ */
+
+#ifndef DIARIO_HH
+#define DIARIO_HH
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#include "Salida.hh"
+#ifndef NO_DIAGRAM
+#    include <memory>
+#    include <ostream>
+#    include <string>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Diario de las instrucciones que modifican el almacén, para poder
+ * recuperarlo tras una interrupción.
+ *
+ * El estado se guarda por generaciones. La generación @em g consiste en una
+ * instantánea (ver Almacen::guardar) <tt>prefijo.g.snap</tt>, con el estado al
+ * empezarla, y un diario <tt>prefijo.g.diario</tt> con las instrucciones
+ * ejecutadas después, en el mismo formato de texto que la entrada. El
+ * fichero <tt>prefijo.actual</tt> contiene el número de la generación vigente
+ * (si no existe, es la 0, que no tiene instantánea: parte del almacén leído
+ * de la entrada).
+ *
+ * Las instrucciones se anotan en un buffer y se escriben en grupo (con una
+ * sola llamada a @c write y a @c fdatasync) cada @em lote instrucciones,
+ * antes de escribir cualquier respuesta (ligando el diario a la salida; ver
+ * Salida::ligar) y al cerrar el diario. Así una respuesta nunca es visible
+ * antes de que la instrucción esté en el disco, pero el coste de la
+ * sincronización se reparte entre muchas instrucciones.
+ *
+ * Un punto de control empieza una generación nueva: guarda una instantánea
+ * y un diario vacío, y sólo entonces cambia <tt>prefijo.actual</tt> (de forma
+ * atómica, con @c rename). Si se interrumpe antes, la generación anterior
+ * sigue completa. Tras crear, sustituir o borrar cada fichero se sincroniza
+ * también el directorio (ver sincronizar_directorio()), porque el @c fsync
+ * de un fichero no garantiza que su entrada en el directorio llegue al
+ * disco.
+ */
+class Diario {
+private:
+    /// Prefijo de los ficheros.
+    string prefijo;
+    /// Generación vigente.
+    int generacion;
+    /// Número de instrucciones que se escriben juntas.
+    int lote;
+    /// Instrucciones anotadas desde la última escritura.
+    int pendientes;
+
+    /// Descriptor del diario de la generación vigente (o -1 si está cerrado).
+    int fd;
+    /// Buffer de escritura del diario (sincronizado con el disco).
+    unique_ptr<Salida> salida;
+    /// Stream sobre @ref salida.
+    ostream os;
+
+    /// Nombre del fichero de la generación @c g con extensión @c extension.
+    string fichero(int g, const char *extension) const;
+
+    /** Abre el diario de la generación vigente para añadir instrucciones.
+     *
+     * @retval false
+     * No se ha podido abrir.
+     */
+    bool abrir();
+
+    /// Cierra el diario (escribiendo lo pendiente), si está abierto.
+    void cerrar();
+
+public:
+    /** Crea un diario, sin abrirlo.
+     *
+     * @param prefijo
+     * Prefijo de los ficheros del diario.
+     *
+     * @param lote
+     * Número de instrucciones que se escriben juntas (>= 1).
+     */
+    Diario(const string &prefijo, int lote);
+
+    /// Cierra el diario.
+    ~Diario();
+
+    /** Indica si una instrucción modifica el almacén (y, por lo tanto, se
+     * anota en el diario).
+     */
+    static bool modifica(TipoComando tipo);
+
+    /** Recupera el estado guardado y abre el diario.
+     *
+     * Carga la instantánea de la generación vigente (si no es la 0) y
+     * ejecuta las instrucciones de su diario. Una última línea incompleta
+     * (de una escritura interrumpida) se descarta.
+     *
+     * @param almacen
+     * Almacén leído de la entrada.
+     *
+     * @returns
+     * El número de instrucciones ejecutadas del diario, o -1 si no se ha
+     * podido cargar la instantánea o abrir el diario.
+     *
+     * @cost
+     * El de cargar la instantánea y ejecutar las instrucciones del diario
+     */
+    long long recuperar(Almacen &almacen);
+
+    /** Anota una instrucción, si modifica el almacén.
+     *
+     * @pre
+     * El diario está abierto (ver recuperar()).
+     *
+     * @cost
+     * Constante (amortizado), más una escritura cada @ref lote instrucciones
+     */
+    void anotar(const Comando &comando);
+
+    /** Escribe las instrucciones pendientes y espera a que lleguen al disco.
+     *
+     * @retval false
+     * Ha habido un error de escritura.
+     */
+    bool confirmar();
+
+    /** Hace un punto de control: guarda el almacén y empieza una generación
+     * nueva, con el diario vacío. Después se borran los ficheros de la
+     * generación anterior.
+     *
+     * @param almacen
+     * Almacén con todas las instrucciones anotadas ejecutadas.
+     *
+     * @retval false
+     * No se ha podido guardar el almacén o empezar la generación; la
+     * generación vigente no ha cambiado.
+     *
+     * @cost
+     * El de Almacen::guardar
+     */
+    bool punto_control(const Almacen &almacen);
+
+    /** Stream del diario, para ligarlo a la salida (ver Salida::ligar).
+     *
+     * Vaciarlo equivale a confirmar().
+     */
+    ostream &flujo();
+};
+
+#endif // DIARIO_HH
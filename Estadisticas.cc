@@ -0,0 +1,93 @@
+/** @file
+ * Implementación de Estadisticas.
+ */
+#include "Estadisticas.hh"
+#ifndef NO_DIAGRAM
+#    include <algorithm> // std::min
+#    include <cassert>
+#endif
+
+/*------------------+
+ | Métodos privados |
+ +------------------*/
+
+// Los valores 0 a 7 tienen un intervalo cada uno; a partir de 8, cada
+// potencia de 2 [2^k, 2^(k+1)) se divide en 4 intervalos iguales.
+
+int Estadisticas::intervalo(long long ns) {
+    if (ns < 8) return ns < 0 ? 0 : ns;
+    int k = 63 - __builtin_clzll(ns); // 2^k <= ns < 2^(k+1), k >= 3
+    int sub = (ns >> (k - 2)) & 3;
+    return 8 + 4 * (k - 3) + sub;
+}
+
+long long Estadisticas::cota(int intervalo) {
+    if (intervalo < 8) return intervalo;
+    int k = (intervalo - 8) / 4 + 3;
+    long long sub = (intervalo - 8) % 4;
+    return ((4 + sub + 1) << (k - 2)) - 1;
+}
+
+long long Estadisticas::percentil(int tipo, double p) const {
+    const vector<long long> &h = histograma[tipo];
+    long long total = 0;
+    for (int i = 0; i < NUM_INTERVALOS; ++i) total += h[i];
+    assert(total > 0);
+    long long objetivo = max(1LL, (long long)(p * total + 0.5));
+    long long acumulado = 0;
+    int i = 0;
+    while (acumulado + h[i] < objetivo) acumulado += h[i++];
+    return min(cota(i), maximo[tipo]);
+}
+
+/*---------------+
+ | Constructores |
+ +---------------*/
+
+Estadisticas::Estadisticas(bool medir_latencia)
+    : medir(medir_latencia), cuenta(NUM_TIPOS, 0), maximo(NUM_TIPOS, -1) {
+    if (medir) {
+        histograma = vector<vector<long long> >(
+            NUM_TIPOS, vector<long long>(NUM_INTERVALOS, 0));
+    }
+}
+
+/*------------------+
+ | Métodos públicos |
+ +------------------*/
+
+bool Estadisticas::mide_latencia() const {
+    return medir;
+}
+
+void Estadisticas::contar(TipoComando tipo) {
+    ++cuenta[tipo];
+}
+
+void Estadisticas::registrar(TipoComando tipo, long long ns) {
+    assert(medir);
+    ++cuenta[tipo];
+    ++histograma[tipo][intervalo(ns)];
+    if (ns > maximo[tipo]) maximo[tipo] = ns;
+}
+
+void Estadisticas::escribir(ostream &os, const Trabajo &trabajo) const {
+    os << "  instruccion cuenta p50_ns p99_ns max_ns" << '\n';
+    for (int tipo = 0; tipo < NUM_TIPOS; ++tipo) {
+        if (cuenta[tipo] == 0) continue;
+        os << "  " << nombre_comando(TipoComando(tipo)) << ' '
+           << cuenta[tipo];
+        // Las instrucciones sin ejecutar (estadisticas) no tienen latencia
+        if (maximo[tipo] >= 0) {
+            os << ' ' << percentil(tipo, 0.5) << ' ' << percentil(tipo, 0.99)
+               << ' ' << maximo[tipo];
+        } else {
+            os << " - - -";
+        }
+        os << '\n';
+    }
+    os << "  posiciones_ocupadas " << trabajo.posiciones_ocupadas << '\n';
+    os << "  posiciones_liberadas " << trabajo.posiciones_liberadas << '\n';
+    os << "  salas_visitadas " << trabajo.salas_visitadas << '\n';
+    os << "  comparaciones " << trabajo.comparaciones << '\n';
+}
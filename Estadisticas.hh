@@ -0,0 +1,137 @@
+/** @file
+ * Archivo que define Estadisticas.
+ */
+
+#ifndef ESTADISTICAS_HH
+#define ESTADISTICAS_HH
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#ifndef NO_DIAGRAM
+#    include <ostream>
+#    include <vector>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Estadísticas de las instrucciones ejecutadas.
+ *
+ * Cuenta las instrucciones de cada tipo y, si se ha pedido, guarda un
+ * histograma de su latencia (el tiempo de ejecutar(), sin la lectura ni la
+ * escritura). Contar una instrucción cuesta una suma; sólo la latencia
+ * requiere consultar el reloj, así que cuando no se mide el coste de las
+ * estadísticas es prácticamente nulo.
+ *
+ * Los histogramas tienen 4 intervalos por cada potencia de 2, así que los
+ * percentiles tienen un error relativo de como mucho un 25%. Los máximos
+ * son exactos.
+ */
+class Estadisticas {
+private:
+    /// Número de tipos de instrucción.
+    static const int NUM_TIPOS = DESCONOCIDO + 1;
+    /// Número de intervalos de cada histograma.
+    static const int NUM_INTERVALOS = 256;
+
+    /// Indica si se mide la latencia.
+    bool medir;
+    /// Número de instrucciones de cada tipo.
+    vector<long long> cuenta;
+    /** Histograma de la latencia de cada tipo: <tt>histograma[tipo][i]</tt>
+     * es el número de instrucciones cuya latencia está en el intervalo @c i.
+     */
+    vector<vector<long long> > histograma;
+    /// Latencia máxima de cada tipo en ns, o -1 si no se ha medido ninguna.
+    vector<long long> maximo;
+
+    /** Intervalo del histograma de una latencia.
+     *
+     * @param ns
+     * Latencia en nanosegundos (>= 0).
+     *
+     * @cost
+     * Constante
+     */
+    static int intervalo(long long ns);
+
+    /** Cota superior (incluida) de un intervalo del histograma.
+     *
+     * @cost
+     * Constante
+     */
+    static long long cota(int intervalo);
+
+    /** Percentil de la latencia de un tipo de instrucción.
+     *
+     * @param tipo
+     * Tipo de instrucción.
+     *
+     * @param p
+     * Fracción de las instrucciones (p.ej. 0.99 para el percentil 99).
+     *
+     * @returns
+     * La cota superior del intervalo que contiene el percentil, sin pasar del
+     * máximo.
+     *
+     * @pre
+     * Se ha medido alguna instrucción de tipo @c tipo.
+     *
+     * @cost
+     * Lineal en el número de intervalos
+     */
+    long long percentil(int tipo, double p) const;
+
+public:
+    /** Crea unas estadísticas vacías.
+     *
+     * @param medir_latencia
+     * Si se medirá la latencia de las instrucciones.
+     */
+    explicit Estadisticas(bool medir_latencia);
+
+    /// Indica si se mide la latencia de las instrucciones.
+    bool mide_latencia() const;
+
+    /** Cuenta una instrucción, sin latencia.
+     *
+     * @cost
+     * Constante
+     */
+    void contar(TipoComando tipo);
+
+    /** Cuenta una instrucción y su latencia.
+     *
+     * @param tipo
+     * Tipo de instrucción.
+     *
+     * @param ns
+     * Latencia en nanosegundos.
+     *
+     * @pre
+     * mide_latencia()
+     *
+     * @cost
+     * Constante
+     */
+    void registrar(TipoComando tipo, long long ns);
+
+    /** Escribe las estadísticas.
+     *
+     * Escribe una línea por cada tipo de instrucción ejecutada, con el número
+     * de instrucciones y su latencia (percentiles 50 y 99 y máximo, en
+     * nanosegundos, o @c - si no se mide), y una línea por cada contador de
+     * @c trabajo.
+     *
+     * @param os
+     * Stream de salida.
+     *
+     * @param trabajo
+     * Trabajo hecho por el almacén.
+     *
+     * @cost
+     * Lineal en el número de tipos de instrucción
+     */
+    void escribir(ostream &os, const Trabajo &trabajo) const;
+};
+
+#endif // ESTADISTICAS_HH
@@ -0,0 +1,146 @@
+/** @file
+ * Implementación de Lector y @ref Token.
+ */
+#include "Lector.hh"
+#ifndef NO_DIAGRAM
+#    include <cassert>
+#    include <cerrno>
+#    include <cstring>
+#    include <unistd.h> // read
+#endif
+
+/// Tamaño inicial del buffer de Lector.
+static const int TAM_BLOQUE = 1 << 16;
+
+/// Indica si @c c es un espacio en blanco.
+static inline bool es_blanco(char c) {
+    return c == ' ' or c == '\n' or c == '\t' or c == '\r' or c == '\v' or
+           c == '\f';
+}
+
+/*-------+
+ | Token |
+ +-------*/
+
+bool Token::operator==(const char *s) const {
+    return strncmp(datos, s, longitud) == 0 and s[longitud] == '\0';
+}
+
+bool Token::operator!=(const char *s) const {
+    return not(*this == s);
+}
+
+bool Token::entero(int &n) const {
+    const char *p = datos;
+    const char *final = p + longitud;
+    bool negativo = (*p == '-');
+    if (*p == '-' or *p == '+') ++p;
+    if (p == final) return false;
+    n = 0;
+    for (; p < final; ++p) {
+        if (*p < '0' or *p > '9') return false;
+        n = 10 * n + (*p - '0');
+    }
+    if (negativo) n = -n;
+    return true;
+}
+
+ostream &operator<<(ostream &os, const Token &token) {
+    return os.write(token.datos, token.longitud);
+}
+
+/*------------------+
+ | Métodos privados |
+ +------------------*/
+
+bool Lector::rellenar() {
+    if (eof) return false;
+    if (inicio > 0) {
+        memmove(buffer.data(), buffer.data() + inicio, fin - inicio);
+        fin -= inicio;
+        inicio = 0;
+    }
+    if (fin == buffer.size()) buffer.resize(2 * buffer.size());
+    if (ligado != NULL) ligado->flush();
+    ssize_t leido;
+    do {
+        leido = read(fd, buffer.data() + fin, buffer.size() - fin);
+    } while (leido < 0 and errno == EINTR);
+    if (leido <= 0) {
+        eof = true;
+        return false;
+    }
+    fin += leido;
+    return true;
+}
+
+/*---------------+
+ | Constructores |
+ +---------------*/
+
+Lector::Lector(int fd)
+    : fd(fd), buffer(TAM_BLOQUE), inicio(0), fin(0), eof(false),
+      ligado(NULL) {}
+
+Lector::Lector(const char *datos, int longitud)
+    : fd(-1), buffer(datos, datos + longitud), inicio(0), fin(longitud),
+      eof(true), ligado(NULL) {}
+
+/*------------------+
+ | Métodos públicos |
+ +------------------*/
+
+void Lector::ligar(ostream *os) {
+    ligado = os;
+}
+
+bool Lector::leer(Token &token) {
+    // Salta los espacios
+    do {
+        while (inicio < fin and es_blanco(buffer[inicio])) ++inicio;
+    } while (inicio == fin and rellenar());
+    if (inicio == fin) return false;
+
+    // Busca el final de la palabra; si llega al final de los datos leídos,
+    // la palabra puede continuar en el siguiente bloque.
+    int i = inicio;
+    while (true) {
+        while (i < fin and not es_blanco(buffer[i])) ++i;
+        if (i < fin) break;
+        int desplazamiento = inicio;
+        bool quedan = rellenar();
+        i -= desplazamiento - inicio; // rellenar() mueve los datos al principio
+        if (not quedan) break;
+    }
+    token.datos = buffer.data() + inicio;
+    token.longitud = i - inicio;
+    inicio = i;
+    return true;
+}
+
+bool Lector::leer(string &s) {
+    Token token;
+    if (not leer(token)) return false;
+    s.assign(token.datos, token.longitud);
+    return true;
+}
+
+bool Lector::leer(int &n) {
+    Token token;
+    return leer(token) and token.entero(n);
+}
+
+bool Lector::leer_bytes(Token &datos, int n) {
+    while (fin - inicio < n) {
+        if (not rellenar()) return false;
+    }
+    datos.datos = buffer.data() + inicio;
+    datos.longitud = n;
+    inicio += n;
+    return true;
+}
+
+int Lector::posicion() const {
+    assert(fd == -1);
+    return inicio;
+}
@@ -0,0 +1,203 @@
+/** @file
+ * Archivo que define Lector y @ref Token.
+ */
+
+#ifndef LECTOR_HH
+#define LECTOR_HH
+
+#include "aux.hh"
+#ifndef NO_DIAGRAM
+#    include <ostream>
+#    include <vector>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Palabra de la entrada, sin copiarla.
+ *
+ * Apunta al buffer de un Lector (como un @c std::string_view de C++17), así
+ * que sólo es válida hasta la siguiente lectura.
+ */
+struct Token {
+    /// Primer carácter de la palabra.
+    const char *datos;
+    /// Número de caracteres de la palabra.
+    int longitud;
+
+    /** Compara la palabra con una cadena.
+     *
+     * @cost
+     * Lineal en la longitud de @c s
+     */
+    bool operator==(const char *s) const;
+
+    /// Negación de operator==().
+    bool operator!=(const char *s) const;
+
+    /** Convierte la palabra en un entero en base 10, con signo opcional.
+     *
+     * @param[out] n
+     * Entero de la palabra.
+     *
+     * @retval false
+     * La palabra no es un entero.
+     *
+     * @cost
+     * Lineal en la longitud de la palabra
+     */
+    bool entero(int &n) const;
+};
+
+/// Escribe la palabra en @c os.
+ostream &operator<<(ostream &os, const Token &token);
+
+/** Lector de palabras y enteros de un descriptor de fichero.
+ *
+ * Lee la entrada por bloques con @c read(2) y la separa en palabras
+ * (secuencias de caracteres sin espacios en blanco) sin pasar por @c
+ * iostream, ni su @c locale, ni copias intermedias.
+ */
+class Lector {
+private:
+    /// Descriptor del que se lee.
+    int fd;
+
+    /** Datos leídos.
+     *
+     * @invariant
+     * Los datos pendientes de procesar son [@ref inicio, @ref fin).
+     */
+    vector<char> buffer;
+    /// Posición del primer carácter pendiente de @ref buffer.
+    int inicio;
+    /// Posición siguiente al último carácter leído de @ref buffer.
+    int fin;
+    /// Indica si se ha llegado al final del fichero.
+    bool eof;
+
+    /// Stream que se vacía antes de cada lectura (o NULL).
+    ostream *ligado;
+
+    /** Lee otro bloque del descriptor.
+     *
+     * Mueve los datos pendientes al principio de @ref buffer (o amplía el
+     * buffer, si está lleno) y añade lo que se pueda leer con una llamada a
+     * @c read(2).
+     *
+     * @retval true
+     * Se ha leído algún carácter.
+     *
+     * @retval false
+     * No quedan datos (final del fichero o error); @ref eof es @c true.
+     *
+     * @cost
+     * Lineal en el número de caracteres pendientes y leídos
+     */
+    bool rellenar();
+
+public:
+    /** Crea un lector.
+     *
+     * @param fd
+     * Descriptor del que leer.
+     *
+     * @cost
+     * Constante
+     */
+    explicit Lector(int fd);
+
+    /** Crea un lector de datos en memoria (p.ej. los recibidos por un
+     * socket), como si fueran un fichero entero.
+     *
+     * @param datos
+     * Datos a leer (se copian).
+     *
+     * @param longitud
+     * Número de caracteres de @c datos.
+     *
+     * @cost
+     * Lineal en @c longitud
+     */
+    Lector(const char *datos, int longitud);
+
+    /** Liga un stream al lector: se vaciará antes de cada lectura de @c fd
+     * (como hace @c cin.tie()).
+     *
+     * @param os
+     * Stream a ligar, o NULL para no ligar ninguno.
+     */
+    void ligar(ostream *os);
+
+    /** Lee una palabra.
+     *
+     * @param[out] token
+     * Palabra leída. Es válida hasta la siguiente lectura.
+     *
+     * @retval true
+     * Se ha leído una palabra.
+     *
+     * @retval false
+     * No quedan palabras en la entrada.
+     *
+     * @cost
+     * Lineal en la longitud de la palabra (y de los espacios que la preceden)
+     */
+    bool leer(Token &token);
+
+    /** Lee una palabra y la copia en una cadena.
+     *
+     * @param[out] s
+     * Palabra leída.
+     *
+     * @returns
+     * Lo mismo que leer(Token &).
+     */
+    bool leer(string &s);
+
+    /** Lee un entero en base 10, con signo opcional.
+     *
+     * @param[out] n
+     * Entero leído.
+     *
+     * @retval true
+     * Se ha leído un entero.
+     *
+     * @retval false
+     * No quedan palabras o la siguiente palabra no es un entero.
+     *
+     * @cost
+     * Lineal en la longitud de la palabra
+     */
+    bool leer(int &n);
+
+    /** Lee @c n caracteres tal cual, sin separarlos en palabras (p.ej. una
+     * trama del protocolo binario, ver Protocolo.hh).
+     *
+     * @param[out] datos
+     * Caracteres leídos; como cualquier Token, sólo es válido hasta la
+     * siguiente lectura.
+     *
+     * @param n
+     * Número de caracteres a leer.
+     *
+     * @retval true
+     * Se han leído los @c n caracteres.
+     *
+     * @retval false
+     * La entrada se ha acabado antes.
+     *
+     * @cost
+     * Lineal en @c n
+     */
+    bool leer_bytes(Token &datos, int n);
+
+    /** Número de caracteres consumidos desde el principio de la entrada
+     * (sólo para lectores de datos en memoria).
+     *
+     * @cost
+     * Constante
+     */
+    int posicion() const;
+};
+
+#endif // LECTOR_HH
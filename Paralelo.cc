@@ -0,0 +1,198 @@
+/** @file
+ * Implementación de EjecutorParalelo.
+ */
+#include "Paralelo.hh"
+#ifndef NO_DIAGRAM
+#    include <cassert>
+#    include <chrono>
+#    include <sstream>
+#endif
+
+/** Ejecuta una instrucción de sala con las operaciones diferidas de Almacen.
+ *
+ * @param almacen
+ * Almacén.
+ *
+ * @param comando
+ * Instrucción (ver EjecutorParalelo::admite).
+ *
+ * @param[out] resultado
+ * Resultado de la instrucción.
+ *
+ * @param[out] listado
+ * Listado escrito por la instrucción.
+ *
+ * @param cambios
+ * Cambios globales de la instrucción.
+ */
+static void ejecutar_en_sala(Almacen &almacen, const Comando &comando,
+                             Resultado &resultado, string &listado,
+                             CambiosSala &cambios) {
+    switch (comando.tipo) {
+        case PONER_ITEMS:
+            resultado.valor = almacen.poner_items(
+                comando.id_sala, comando.id_producto, comando.cantidad, cambios);
+            break;
+        case QUITAR_ITEMS:
+            resultado.valor = almacen.quitar_items(
+                comando.id_sala, comando.id_producto, comando.cantidad, cambios);
+            break;
+        case REDIMENSIONAR:
+            resultado.valor = almacen.redimensionar(comando.id_sala, comando.f,
+                                                    comando.c, cambios);
+            break;
+        case ESCRIBIR: {
+            ostringstream os;
+            almacen.escribir(comando.id_sala, os);
+            listado = os.str();
+            break;
+        }
+        default: {
+            // No modifican el estado global ni escriben ningún listado
+            ostream nulo(NULL);
+            ejecutar(almacen, comando, resultado, nulo);
+        }
+    }
+}
+
+/*------------------+
+ | Métodos privados |
+ +------------------*/
+
+void EjecutorParalelo::hacer(int hilo, Fase f) {
+    if (f == EJECUTAR) {
+        for (int i : asignadas[hilo]) {
+            Entrada &e = entradas[i];
+            if (medir) {
+                chrono::steady_clock::time_point inicio =
+                    chrono::steady_clock::now();
+                ejecutar_en_sala(almacen, e.comando, e.resultado, e.listado,
+                                 cambios[hilo]);
+                chrono::nanoseconds ns = chrono::steady_clock::now() - inicio;
+                e.ns = ns.count();
+            } else {
+                ejecutar_en_sala(almacen, e.comando, e.resultado, e.listado,
+                                 cambios[hilo]);
+            }
+        }
+    } else if (f == APLICAR) {
+        for (const CambiosSala &c : cambios) {
+            almacen.aplicar_productos(c, hilo, num_hilos);
+        }
+    }
+}
+
+void EjecutorParalelo::repartir(Fase f) {
+    {
+        lock_guard<mutex> lock(m);
+        fase = f;
+        ++ronda;
+        pendientes = num_hilos - 1;
+    }
+    cv_fase.notify_all();
+    hacer(0, f);
+    unique_lock<mutex> lock(m);
+    cv_fin.wait(lock, [this] { return pendientes == 0; });
+}
+
+void EjecutorParalelo::trabajar(int hilo) {
+    long long vista = 0; // Última ronda hecha
+    while (true) {
+        Fase f;
+        {
+            unique_lock<mutex> lock(m);
+            cv_fase.wait(lock, [this, vista] { return ronda != vista; });
+            vista = ronda;
+            f = fase;
+        }
+        if (f == TERMINAR) return;
+        hacer(hilo, f);
+        lock_guard<mutex> lock(m);
+        if (--pendientes == 0) cv_fin.notify_one();
+    }
+}
+
+/*---------------+
+ | Constructores |
+ +---------------*/
+
+EjecutorParalelo::EjecutorParalelo(Almacen &almacen, int num_hilos,
+                                   int capacidad, bool medir)
+    : almacen(almacen), num_hilos(num_hilos), medir(medir),
+      entradas(capacidad), num_entradas(0), asignadas(num_hilos),
+      cambios(num_hilos), fase(EJECUTAR), ronda(0), pendientes(0) {
+    assert(num_hilos >= 1 and capacidad >= 1);
+    for (int hilo = 1; hilo < num_hilos; ++hilo) {
+        hilos.push_back(thread(&EjecutorParalelo::trabajar, this, hilo));
+    }
+}
+
+EjecutorParalelo::~EjecutorParalelo() {
+    assert(num_entradas == 0);
+    {
+        lock_guard<mutex> lock(m);
+        fase = TERMINAR;
+        ++ronda;
+    }
+    cv_fase.notify_all();
+    for (thread &t : hilos) t.join();
+}
+
+/*------------------+
+ | Métodos públicos |
+ +------------------*/
+
+bool EjecutorParalelo::admite(TipoComando tipo) {
+    switch (tipo) {
+        case PONER_ITEMS:
+        case QUITAR_ITEMS:
+        case COMPACTAR:
+        case REORGANIZAR:
+        case REDIMENSIONAR:
+        case ESCRIBIR:
+        case CONSULTAR_POS: return true;
+        default: return false;
+    }
+}
+
+void EjecutorParalelo::anadir(const Comando &comando) {
+    assert(admite(comando.tipo) and not lleno());
+    assert(0 < comando.id_sala and comando.id_sala <= almacen.num_salas());
+    Entrada &e = entradas[num_entradas++];
+    e.comando = comando;
+    e.listado.clear();
+}
+
+bool EjecutorParalelo::lleno() const {
+    return num_entradas == entradas.size();
+}
+
+int EjecutorParalelo::vaciar(ostream &os, Estadisticas &estadisticas) {
+    if (num_entradas == 0) return 0;
+    for (vector<int> &a : asignadas) a.clear();
+    for (int i = 0; i < num_entradas; ++i) {
+        asignadas[(entradas[i].comando.id_sala - 1) % num_hilos].push_back(i);
+    }
+    repartir(EJECUTAR);
+    almacen.separar_inventario();
+    repartir(APLICAR);
+    for (CambiosSala &c : cambios) {
+        almacen.aplicar_salas(c);
+        c.limpiar();
+    }
+
+    for (int i = 0; i < num_entradas; ++i) {
+        const Entrada &e = entradas[i];
+        escribir_eco(os, e.comando);
+        os << e.listado;
+        escribir_resultado(os, e.comando, e.resultado);
+        if (medir) {
+            estadisticas.registrar(e.comando.tipo, e.ns);
+        } else {
+            estadisticas.contar(e.comando.tipo);
+        }
+    }
+    int ejecutadas = num_entradas;
+    num_entradas = 0;
+    return ejecutadas;
+}
@@ -0,0 +1,188 @@
+/** @file
+ * Archivo que define EjecutorParalelo.
+ */
+
+#ifndef PARALELO_HH
+#define PARALELO_HH
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#include "Estadisticas.hh"
+#ifndef NO_DIAGRAM
+#    include <condition_variable>
+#    include <mutex>
+#    include <ostream>
+#    include <string>
+#    include <thread>
+#    include <vector>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Ejecución en paralelo de las instrucciones que sólo acceden a una sala.
+ *
+ * Las instrucciones de sala (ver admite()) se acumulan en un lote. Al
+ * vaciarlo, las salas se reparten entre los hilos (la sala @em s es del hilo
+ * (@em s - 1) mod @em n), y cada hilo ejecuta en orden las instrucciones de
+ * sus salas con las operaciones diferidas de Almacen, anotando los cambios
+ * globales en su propio CambiosSala. Como las salas son independientes, el
+ * resultado es el mismo que ejecutar el lote en orden.
+ *
+ * Después, los hilos aplican los cambios de los productos (repartidos por
+ * código, de forma que cada producto es de un solo hilo), el hilo principal
+ * aplica el resto (espacio libre y trabajo) y escribe el eco y el resultado
+ * de cada instrucción en el orden original.
+ *
+ * El hilo principal hace de hilo 0, así que con @em n hilos se crean
+ * @em n - 1 hilos auxiliares, que esperan entre lote y lote. El resto de
+ * instrucciones se tienen que ejecutar con el lote vacío (ver vaciar()).
+ */
+class EjecutorParalelo {
+private:
+    /// Instrucción del lote, con su resultado.
+    struct Entrada {
+        /// Instrucción.
+        Comando comando;
+        /// Resultado de la instrucción.
+        Resultado resultado;
+        /// Listado escrito por la instrucción (en @c escribir).
+        string listado;
+        /// Latencia de la instrucción en nanosegundos, si se mide.
+        long long ns;
+    };
+
+    /// Trabajo que hacen los hilos.
+    enum Fase {
+        /// Ejecutar las instrucciones de sus salas.
+        EJECUTAR,
+        /// Aplicar los cambios de sus productos.
+        APLICAR,
+        /// Terminar (al destruir el objeto).
+        TERMINAR
+    };
+
+    /// Almacén sobre el que se ejecutan las instrucciones.
+    Almacen &almacen;
+    /// Número de hilos, incluido el principal.
+    int num_hilos;
+    /// Si se mide la latencia de cada instrucción.
+    bool medir;
+
+    /** Instrucciones del lote. Sólo son válidas las @ref num_entradas
+     * primeras; el resto se conservan para reutilizar su memoria.
+     */
+    vector<Entrada> entradas;
+    /// Número de instrucciones del lote.
+    int num_entradas;
+    /// Posiciones en @ref entradas de las instrucciones de cada hilo.
+    vector<vector<int> > asignadas;
+    /// Cambios globales pendientes de cada hilo.
+    vector<CambiosSala> cambios;
+
+    /// Hilos auxiliares (los hilos 1 a @ref num_hilos - 1).
+    vector<thread> hilos;
+    /// Protege @ref fase, @ref ronda y @ref pendientes.
+    mutex m;
+    /// Avisa a los hilos auxiliares de que hay una fase nueva.
+    condition_variable cv_fase;
+    /// Avisa al hilo principal de que los hilos auxiliares han terminado.
+    condition_variable cv_fin;
+    /// Fase en curso.
+    Fase fase;
+    /// Número de fases empezadas.
+    long long ronda;
+    /// Hilos auxiliares que no han terminado la fase en curso.
+    int pendientes;
+
+    /** Hace la parte de un hilo en una fase.
+     *
+     * @param hilo
+     * Número del hilo (0 es el principal).
+     *
+     * @param f
+     * Fase (@ref EJECUTAR o @ref APLICAR).
+     */
+    void hacer(int hilo, Fase f);
+
+    /** Hace una fase en todos los hilos y espera a que terminen.
+     *
+     * @param f
+     * Fase.
+     */
+    void repartir(Fase f);
+
+    /** Bucle de un hilo auxiliar: hace su parte de cada fase hasta
+     * @ref TERMINAR.
+     *
+     * @param hilo
+     * Número del hilo (> 0).
+     */
+    void trabajar(int hilo);
+
+public:
+    /** Crea un ejecutor y sus hilos auxiliares.
+     *
+     * @param almacen
+     * Almacén sobre el que se ejecutarán las instrucciones.
+     *
+     * @param num_hilos
+     * Número de hilos (>= 1), incluido el principal.
+     *
+     * @param capacidad
+     * Número máximo de instrucciones de un lote (>= 1).
+     *
+     * @param medir
+     * Si se mide la latencia de cada instrucción (ver Estadisticas).
+     */
+    EjecutorParalelo(Almacen &almacen, int num_hilos, int capacidad,
+                     bool medir);
+
+    /** Termina los hilos auxiliares.
+     *
+     * @pre
+     * El lote está vacío.
+     */
+    ~EjecutorParalelo();
+
+    /** Indica si una instrucción sólo accede a una sala (@ref
+     * Comando::id_sala) y se puede ejecutar en paralelo.
+     */
+    static bool admite(TipoComando tipo);
+
+    /** Añade una instrucción al lote.
+     *
+     * @pre
+     * admite(<tt>comando.tipo</tt>), no lleno() y
+     * 0 < <tt>comando.id_sala</tt> <= Almacen::num_salas.
+     *
+     * @cost
+     * Lineal en el tamaño de @c comando
+     */
+    void anadir(const Comando &comando);
+
+    /// Indica si el lote está lleno.
+    bool lleno() const;
+
+    /** Ejecuta el lote y escribe, en orden, el eco, el listado y el
+     * resultado de cada instrucción.
+     *
+     * @param os
+     * Stream de salida.
+     *
+     * @param estadisticas
+     * Estadísticas en las que se cuentan las instrucciones.
+     *
+     * @returns
+     * El número de instrucciones ejecutadas.
+     *
+     * @post
+     * El lote está vacío y el almacén refleja todas sus instrucciones.
+     *
+     * @cost
+     * El de las instrucciones, repartido entre los hilos, más lineal en el
+     * número de ítems movidos por cada hilo
+     */
+    int vaciar(ostream &os, Estadisticas &estadisticas);
+};
+
+#endif // PARALELO_HH
@@ -0,0 +1,287 @@
+/** @file
+ * Implementación de CodificadorBinario y DecodificadorBinario.
+ */
+#include "Protocolo.hh"
+#ifndef NO_DIAGRAM
+#    include <cstring>
+#endif
+
+/// Longitud máxima de una trama: una longitud mayor está mal formada.
+static const uint32_t MAX_TRAMA = 1 << 30;
+
+/// Lee un entero de 32 bits.
+static bool leer_entero(LectorBinario &lector, int &n) {
+    int32_t v;
+    if (not lector.leer(v)) return false;
+    n = v;
+    return true;
+}
+
+/// Lee una longitud y esa cantidad de caracteres.
+static bool leer_texto(LectorBinario &lector, string &s) {
+    uint32_t n;
+    if (not lector.leer(n) or n > lector.restantes()) return false;
+    s.resize(n);
+    return n == 0 or lector.leer(&s[0], n);
+}
+
+bool listado_estructurado(TipoComando tipo) {
+    return tipo == ESCRIBIR or tipo == INVENTARIO;
+}
+
+/*--------------------+
+ | CodificadorBinario |
+ +--------------------*/
+
+template <class T> void CodificadorBinario::anadir(const T &v) {
+    trama.append(reinterpret_cast<const char *>(&v), sizeof v);
+}
+
+void CodificadorBinario::anadir_texto(const string &s) {
+    anadir(uint32_t(s.size()));
+    trama += s;
+}
+
+uint32_t CodificadorBinario::numero(ostream &os,
+                                    const IdProducto &id_producto) {
+    pair<unordered_map<IdProducto, uint32_t>::iterator, bool> nuevo =
+        productos.insert(make_pair(id_producto, uint32_t(productos.size())));
+    if (nuevo.second) {
+        escribir_binario(os, uint32_t(1 + 4 + id_producto.size()));
+        escribir_binario(os, DEFINIR_PRODUCTO);
+        escribir_binario(os, uint32_t(id_producto.size()));
+        os.write(id_producto.data(), id_producto.size());
+    }
+    return nuevo.first->second;
+}
+
+void CodificadorBinario::anadir_producto(ostream &os,
+                                         const IdProducto &id_producto) {
+    anadir(numero(os, id_producto));
+}
+
+void CodificadorBinario::terminar(ostream &os) {
+    escribir_binario(os, uint32_t(trama.size()));
+    os.write(trama.data(), trama.size());
+    trama.clear();
+}
+
+void CodificadorBinario::escribir_comando(ostream &os,
+                                          const Comando &comando) {
+    anadir(uint8_t(comando.tipo));
+    if (comando.tipo == DESCONOCIDO) anadir_texto(comando.nombre);
+    for (const char *a = argumentos_comando(comando.tipo); *a != '\0'; ++a) {
+        switch (*a) {
+            case 's': anadir(int32_t(comando.id_sala)); break;
+            case 'p': anadir_producto(os, comando.id_producto); break;
+            case 'n': anadir(int32_t(comando.cantidad)); break;
+            case 'f': anadir(int32_t(comando.f)); break;
+            case 'c': anadir(int32_t(comando.c)); break;
+            case 'a': anadir_texto(comando.fichero); break;
+            case 'l':
+                anadir(uint32_t(comando.operaciones.size()));
+                for (const OperacionLote &op : comando.operaciones) {
+                    anadir(uint8_t(op.poner));
+                    anadir(int32_t(op.id_sala));
+                    anadir_producto(os, op.id_producto);
+                    anadir(int32_t(op.cantidad));
+                }
+                break;
+        }
+    }
+    terminar(os);
+}
+
+void CodificadorBinario::escribir_respuesta(ostream &os, TipoComando tipo,
+                                            const Resultado &resultado,
+                                            const string &listado) {
+    anadir(uint8_t(tipo));
+    anadir_texto(listado);
+    switch (tipo_resultado(tipo)) {
+        case NINGUNO: break;
+        case ERROR_SI_FALLA:
+        case CANTIDAD: anadir(int32_t(resultado.valor)); break;
+        case PRODUCTO: anadir_producto(os, resultado.id_producto); break;
+        case CANTIDADES:
+            anadir(uint32_t(resultado.valores.size()));
+            for (int valor : resultado.valores) anadir(int32_t(valor));
+            break;
+    }
+    terminar(os);
+}
+
+void CodificadorBinario::escribir_listado(ostream &os, const Comando &comando,
+                                          const Almacen &almacen) {
+    const Catalogo &catalogo = almacen.consultar_catalogo();
+    anadir(uint8_t(comando.tipo));
+    if (comando.tipo == ESCRIBIR) {
+        const Sala &sala = almacen.consultar_sala(comando.id_sala);
+        const vector<Producto> &ordenado = sala.inventario_ordenado(catalogo);
+        // Cada identificador se busca una vez, no en cada posición; sólo se
+        // consultan los números de productos de la sala, que se acaban de
+        // poner, así que no hace falta borrar los de otras salas.
+        if (numeros.size() < catalogo.max_codigo())
+            numeros.resize(catalogo.max_codigo());
+        for (Producto producto : ordenado) {
+            numeros[producto] = numero(os, catalogo.nombre(producto));
+        }
+        anadir(int32_t(sala.num_filas()));
+        anadir(int32_t(sala.num_columnas()));
+        for (int f = 1; f <= sala.num_filas(); ++f) {
+            for (int c = 1; c <= sala.num_columnas(); ++c) {
+                Producto producto = sala.consultar_pos(f, c);
+                anadir(producto == NINGUN_PRODUCTO ? SIN_PRODUCTO
+                                                   : numeros[producto]);
+            }
+        }
+        const InventarioSala &inventario = sala.consultar_inventario();
+        anadir(uint32_t(ordenado.size()));
+        for (Producto producto : ordenado) {
+            anadir(numeros[producto]);
+            anadir(int32_t(inventario.find(producto)->second.size()));
+        }
+    } else {
+        const vector<Producto> &ordenados = catalogo.ordenados();
+        anadir(uint32_t(ordenados.size()));
+        for (Producto producto : ordenados) {
+            anadir_producto(os, catalogo.nombre(producto));
+            anadir(int32_t(almacen.consultar_cantidad(producto)));
+        }
+    }
+    terminar(os);
+}
+
+/*----------------------+
+ | DecodificadorBinario |
+ +----------------------*/
+
+bool DecodificadorBinario::leer_trama(Lector &lector, uint8_t &tipo,
+                                      Token &datos) {
+    while (true) {
+        uint32_t longitud;
+        if (not lector.leer_bytes(datos, sizeof longitud)) return false;
+        memcpy(&longitud, datos.datos, sizeof longitud);
+        if (longitud < 1 or longitud > MAX_TRAMA or
+            not lector.leer_bytes(datos, longitud))
+            return false;
+        tipo = datos.datos[0];
+        ++datos.datos;
+        --datos.longitud;
+        if (tipo != DEFINIR_PRODUCTO) return true;
+
+        LectorBinario campos(datos.datos, datos.longitud);
+        productos.push_back(IdProducto());
+        if (not leer_texto(campos, productos.back()) or not campos.final())
+            return false;
+    }
+}
+
+bool DecodificadorBinario::leer_producto(LectorBinario &lector,
+                                         IdProducto &id_producto) const {
+    uint32_t n;
+    if (not lector.leer(n) or n >= productos.size()) return false;
+    id_producto = productos[n];
+    return true;
+}
+
+bool DecodificadorBinario::leer_productos(
+    LectorBinario &lector, vector<pair<IdProducto, int> > &lista) const {
+    uint32_t n;
+    if (not lector.leer(n) or n > lector.restantes()) return false;
+    lista.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (not leer_producto(lector, lista[i].first) or
+            not leer_entero(lector, lista[i].second))
+            return false;
+    }
+    return true;
+}
+
+bool DecodificadorBinario::leer_comando(Lector &lector, Comando &comando) {
+    uint8_t tipo;
+    Token datos;
+    if (not leer_trama(lector, tipo, datos) or tipo > DESCONOCIDO)
+        return false;
+    comando.tipo = TipoComando(tipo);
+    LectorBinario campos(datos.datos, datos.longitud);
+    bool ok = comando.tipo != DESCONOCIDO or leer_texto(campos, comando.nombre);
+    for (const char *a = argumentos_comando(comando.tipo); ok and *a != '\0';
+         ++a) {
+        switch (*a) {
+            case 's': ok = leer_entero(campos, comando.id_sala); break;
+            case 'p': ok = leer_producto(campos, comando.id_producto); break;
+            case 'n': ok = leer_entero(campos, comando.cantidad); break;
+            case 'f': ok = leer_entero(campos, comando.f); break;
+            case 'c': ok = leer_entero(campos, comando.c); break;
+            case 'a': ok = leer_texto(campos, comando.fichero); break;
+            case 'l': {
+                uint32_t n;
+                // Cada operación ocupa algún byte: no se reserva de más
+                ok = campos.leer(n) and n <= campos.restantes();
+                if (ok) comando.operaciones.resize(n);
+                for (uint32_t i = 0; ok and i < n; ++i) {
+                    OperacionLote &op = comando.operaciones[i];
+                    uint8_t poner = 0;
+                    ok = campos.leer(poner) and
+                         leer_entero(campos, op.id_sala) and
+                         leer_producto(campos, op.id_producto) and
+                         leer_entero(campos, op.cantidad);
+                    op.poner = poner != 0;
+                }
+                break;
+            }
+        }
+    }
+    return ok and campos.final();
+}
+
+bool DecodificadorBinario::leer_respuesta(Lector &lector, TipoComando &tipo,
+                                          Resultado &resultado,
+                                          Listado &listado) {
+    uint8_t t;
+    Token datos;
+    if (not leer_trama(lector, t, datos) or t > DESCONOCIDO) return false;
+    tipo = TipoComando(t);
+    LectorBinario campos(datos.datos, datos.longitud);
+    listado.texto.clear();
+    bool ok;
+    if (tipo == ESCRIBIR) {
+        // Cada posición ocupa 4 bytes: no se reserva de más
+        ok = leer_entero(campos, listado.filas) and
+             leer_entero(campos, listado.columnas) and listado.filas > 0 and
+             listado.columnas > 0 and
+             listado.filas <= campos.restantes() / 4 / listado.columnas;
+        if (ok) listado.estanteria.resize(listado.filas * listado.columnas);
+        for (int i = 0; ok and i < listado.estanteria.size(); ++i) {
+            uint32_t n;
+            ok = campos.leer(n) and (n == SIN_PRODUCTO or n < productos.size());
+            if (ok) {
+                listado.estanteria[i] =
+                    n == SIN_PRODUCTO ? IdProducto() : productos[n];
+            }
+        }
+        ok = ok and leer_productos(campos, listado.productos);
+    } else if (tipo == INVENTARIO) {
+        ok = leer_productos(campos, listado.productos);
+    } else {
+        ok = leer_texto(campos, listado.texto);
+    }
+    switch (tipo_resultado(tipo)) {
+        case NINGUNO: break;
+        case ERROR_SI_FALLA:
+        case CANTIDAD: ok = ok and leer_entero(campos, resultado.valor); break;
+        case PRODUCTO:
+            ok = ok and leer_producto(campos, resultado.id_producto);
+            break;
+        case CANTIDADES: {
+            uint32_t n;
+            ok = ok and campos.leer(n) and n <= campos.restantes();
+            if (ok) resultado.valores.resize(n);
+            for (uint32_t i = 0; ok and i < n; ++i) {
+                ok = leer_entero(campos, resultado.valores[i]);
+            }
+            break;
+        }
+    }
+    return ok and campos.final();
+}
@@ -0,0 +1,263 @@
+/** @file
+ * Archivo que define el protocolo binario: CodificadorBinario y
+ * DecodificadorBinario.
+ *
+ * Es una alternativa al protocolo de texto (ver Comando.hh) con las mismas
+ * instrucciones y resultados, pero sin eco ni conversiones a decimal. Tanto
+ * las instrucciones como las respuestas son secuencias de tramas. Cada trama
+ * empieza con su longitud (@c uint32_t, sin contarse a sí misma) y su tipo
+ * (@c uint8_t: un @ref TipoComando o @ref DEFINIR_PRODUCTO), seguidos de sus
+ * campos:
+ * - Salas, cantidades, filas, columnas y resultados: @c int32_t.
+ * - Productos: @c uint32_t, el número de orden de la definición del producto
+ *   (ver @ref DEFINIR_PRODUCTO).
+ * - Ficheros, nombres y listados: su longitud (@c uint32_t) y sus
+ *   caracteres.
+ * - Listas de operaciones: su número (@c uint32_t) y, para cada una, un
+ *   @c uint8_t (1 si es @c poner_items y 0 si es @c quitar_items) y su sala,
+ *   producto y cantidad.
+ *
+ * Una trama de instrucción lleva sus argumentos en el mismo orden que en el
+ * protocolo de texto (ver argumentos_comando()); si es @ref DESCONOCIDO,
+ * lleva su nombre. Una trama de respuesta lleva el tipo de la instrucción,
+ * su listado (el mismo texto que en el protocolo de texto, normalmente
+ * vacío) y los campos de @ref Resultado que indique tipo_resultado():
+ * @ref Resultado::valor, @ref Resultado::id_producto o el número de
+ * @ref Resultado::valores y cada uno de ellos.
+ *
+ * Los listados de @c escribir e @c inventario no se escriben como texto,
+ * sino como datos (ver listado_estructurado()):
+ * - @c escribir: las filas y las columnas de la sala, el producto de cada
+ *   posición (@ref SIN_PRODUCTO si está vacía) en el orden del listado de
+ *   texto, y los productos de la sala.
+ * - @c inventario: los productos del catálogo.
+ *
+ * Los productos de un listado son su número (@c uint32_t) y, para cada uno
+ * por orden alfabético, el producto y su número de ítems.
+ *
+ * Como en las instantáneas (ver Binario.hh), los números se escriben con el
+ * orden de bytes de la máquina: el protocolo es para procesos de la misma
+ * máquina.
+ *
+ * La entrada de <tt>program.exe --binario</tt> es la estructura del almacén
+ * en texto, un salto de línea y las tramas de las instrucciones.
+ */
+
+#ifndef PROTOCOLO_HH
+#define PROTOCOLO_HH
+
+#include "Binario.hh"
+#include "Comando.hh"
+#include "Lector.hh"
+#include "aux.hh"
+#ifndef NO_DIAGRAM
+#    include <cstdint>
+#    include <ostream>
+#    include <string>
+#    include <unordered_map>
+#    include <utility>
+#    include <vector>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Tipo de la trama que define un producto: lleva su identificador, y las
+ * tramas siguientes en el mismo sentido se refieren a él con el número de
+ * definiciones anteriores (0 para el primero, 1 para el segundo, ...).
+ */
+const uint8_t DEFINIR_PRODUCTO = 0xFF;
+
+/// Producto de una posición vacía en el listado de @c escribir.
+const uint32_t SIN_PRODUCTO = 0xFFFFFFFF;
+
+/** Indica si la respuesta a una instrucción lleva su listado como datos en
+ * vez de como texto (ver Protocolo.hh): @c escribir e @c inventario.
+ */
+bool listado_estructurado(TipoComando tipo);
+
+/** Listado de una respuesta binaria, leído con
+ * DecodificadorBinario::leer_respuesta().
+ */
+struct Listado {
+    /// Texto del listado, si no es estructurado (ver listado_estructurado()).
+    string texto;
+    /// Filas de la sala (en @c escribir).
+    int filas;
+    /// Columnas de la sala (en @c escribir).
+    int columnas;
+    /** Producto de cada posición de la sala, en el orden del listado de texto
+     * (vacío si la posición está libre; en @c escribir).
+     */
+    vector<IdProducto> estanteria;
+    /// Productos por orden alfabético y sus números de ítems.
+    vector<pair<IdProducto, int> > productos;
+};
+
+/** Escritor de tramas del protocolo binario (ver Protocolo.hh).
+ *
+ * Recuerda los productos que ya ha definido: cada producto se define (con
+ * una trama @ref DEFINIR_PRODUCTO) la primera vez que aparece en una trama.
+ */
+class CodificadorBinario {
+private:
+    /// Número de cada producto definido.
+    unordered_map<IdProducto, uint32_t> productos;
+    /** Número de cada producto de la sala que se está escribiendo, por su
+     * código (ver escribir_listado()).
+     */
+    vector<uint32_t> numeros;
+    /// Trama en construcción, sin la longitud.
+    string trama;
+
+    /// Añade un valor a @ref trama.
+    template <class T> void anadir(const T &v);
+    /// Añade una longitud y los caracteres de @c s a @ref trama.
+    void anadir_texto(const string &s);
+    /** Devuelve el número de un producto, escribiendo antes su definición en
+     * @c os si es la primera vez que aparece.
+     */
+    uint32_t numero(ostream &os, const IdProducto &id_producto);
+    /// Añade el número de un producto a @ref trama (ver numero()).
+    void anadir_producto(ostream &os, const IdProducto &id_producto);
+    /// Escribe la longitud y el contenido de @ref trama, y la vacía.
+    void terminar(ostream &os);
+
+public:
+    /** Escribe una instrucción.
+     *
+     * @param os
+     * Stream de salida.
+     *
+     * @param comando
+     * Instrucción.
+     *
+     * @cost
+     * Lineal en el tamaño de la instrucción (esperado)
+     */
+    void escribir_comando(ostream &os, const Comando &comando);
+
+    /** Escribe la respuesta a una instrucción.
+     *
+     * @param os
+     * Stream de salida.
+     *
+     * @param tipo
+     * Tipo de la instrucción.
+     *
+     * @param resultado
+     * Resultado de la instrucción.
+     *
+     * @param listado
+     * Listado que ha escrito la instrucción (o vacío).
+     *
+     * @cost
+     * Lineal en el tamaño de la respuesta (esperado)
+     */
+    void escribir_respuesta(ostream &os, TipoComando tipo,
+                            const Resultado &resultado,
+                            const string &listado);
+
+    /** Escribe la respuesta a una instrucción con listado estructurado,
+     * tomando los datos del almacén en lugar de ejecutarla.
+     *
+     * @param os
+     * Stream de salida.
+     *
+     * @param comando
+     * Instrucción.
+     *
+     * @param almacen
+     * Almacén sobre el que se ejecuta la instrucción.
+     *
+     * @pre
+     * listado_estructurado(<tt>comando.tipo</tt>); si es @c escribir, la
+     * sala existe.
+     *
+     * @cost
+     * El de escribir la sala o el inventario en texto (ver
+     * Almacen::escribir y Almacen::inventario), sin convertir nada a texto
+     */
+    void escribir_listado(ostream &os, const Comando &comando,
+                          const Almacen &almacen);
+};
+
+/** Lector de tramas del protocolo binario (ver Protocolo.hh).
+ *
+ * Recuerda los productos definidos por las tramas @ref DEFINIR_PRODUCTO que
+ * ha leído, y las lee por su cuenta: nunca las devuelve.
+ */
+class DecodificadorBinario {
+private:
+    /// Identificador de cada producto definido, por número.
+    vector<IdProducto> productos;
+
+    /** Lee la siguiente trama que no es una definición.
+     *
+     * @param[out] tipo
+     * Tipo de la trama.
+     *
+     * @param[out] datos
+     * Campos de la trama (válidos hasta la siguiente lectura de @c lector).
+     *
+     * @retval false
+     * No quedan tramas o alguna está mal formada.
+     */
+    bool leer_trama(Lector &lector, uint8_t &tipo, Token &datos);
+
+    /// Lee el número de un producto y lo traduce a su identificador.
+    bool leer_producto(LectorBinario &lector, IdProducto &id_producto) const;
+
+    /// Lee los productos de un listado estructurado.
+    bool leer_productos(LectorBinario &lector,
+                        vector<pair<IdProducto, int> > &lista) const;
+
+public:
+    /** Lee una instrucción.
+     *
+     * @param lector
+     * Lector de la entrada.
+     *
+     * @param[out] comando
+     * Instrucción leída.
+     *
+     * @retval true
+     * Se ha leído una instrucción (que puede ser @ref FIN o @ref
+     * DESCONOCIDO).
+     *
+     * @retval false
+     * No quedan instrucciones o la siguiente trama está mal formada.
+     *
+     * @cost
+     * Lineal en el tamaño de la instrucción
+     */
+    bool leer_comando(Lector &lector, Comando &comando);
+
+    /** Lee una respuesta.
+     *
+     * @param lector
+     * Lector de la entrada.
+     *
+     * @param[out] tipo
+     * Tipo de la instrucción respondida.
+     *
+     * @param[out] resultado
+     * Resultado de la instrucción.
+     *
+     * @param[out] listado
+     * Listado que ha escrito la instrucción: los datos si es estructurado
+     * (ver listado_estructurado()) y si no, el texto (o vacío).
+     *
+     * @retval true
+     * Se ha leído una respuesta.
+     *
+     * @retval false
+     * No quedan respuestas o la siguiente trama está mal formada.
+     *
+     * @cost
+     * Lineal en el tamaño de la respuesta
+     */
+    bool leer_respuesta(Lector &lector, TipoComando &tipo,
+                        Resultado &resultado, Listado &listado);
+};
+
+#endif // PROTOCOLO_HH
@@ -3,86 +3,150 @@
  */
 #include "Sala.hh"
 #ifndef NO_DIAGRAM
-#    include <algorithm> // std::sort, std::min
+#    include <algorithm> // std::sort, std::min, std::*_heap
 #    include <cassert>
+#    include <functional> // std::greater
+#    include <utility>    // std::move
 #endif
 
 /*------------------+
- | Statics privados |
+ | Métodos privados |
  +------------------*/
 
-bool Sala::comp_IdProducto(const IdProducto &a, const IdProducto &b) {
-    return (not a.empty()) and (b.empty() or (a < b));
+const vector<Producto> &
+Sala::inventario_ordenado(const Catalogo &catalogo) const {
+    lock_guard<mutex> lock(orden.m);
+    if (orden.valido) return orden.productos;
+    vector<Producto> &productos = orden.productos;
+    productos.clear();
+    productos.reserve(inventario.size());
+    InventarioSala::const_iterator it;
+    for (it = inventario.begin(); it != inventario.end(); ++it) {
+        productos.push_back(it->first);
+    }
+    long long comparaciones = 0;
+    sort(productos.begin(), productos.end(),
+         [&catalogo, &comparaciones](Producto a, Producto b) {
+             ++comparaciones;
+             return catalogo.menor(a, b);
+         });
+    catalogo.contar_comparaciones(comparaciones);
+    orden.valido = true;
+    return productos;
+}
+
+bool Sala::compactada() const {
+    // Hay estantería.size() - elementos huecos; si el primero está en la
+    // posición elementos, ocupan exactamente el final de la estantería.
+    return libres.empty() or libres.front() == elementos;
+}
+
+void Sala::reconstruir_libres() {
+    libres.clear();
+    for (int i = elementos; i < estanteria.size(); ++i) {
+        libres.push_back(i);
+    }
 }
 
 /*---------------+
  | Constructores |
  +---------------*/
 
-Sala::Sala() {}
+Sala::Sala() : ordenada(true) {}
 
 Sala::Sala(int filas, int columnas) {
     assert(filas > 0 and columnas > 0);
     this->filas = filas;
     this->columnas = columnas;
     elementos = 0;
-    estanteria = Estanteria(filas * columnas, "");
+    ordenada = true;
+    estanteria = Estanteria(filas * columnas, NINGUN_PRODUCTO);
+    reconstruir_libres();
 }
 
 /*------------------+
  | Métodos públicos |
  +------------------*/
-int Sala::poner_items(IdProducto producto, int cantidad) {
+int Sala::poner_items(Producto producto, int cantidad) {
     assert(cantidad >= 0);
 
     // Determina el número de elementos a añadir
     int anadir = min(cantidad, filas * columnas - elementos);
     if (anadir == 0) return cantidad;
-    inventario[producto] += anadir;
+    InventarioSala::iterator iit = inventario.find(producto);
+    if (iit == inventario.end()) {
+        iit = inventario.insert({producto, Posiciones()}).first;
+        orden.valido = false; // Ha entrado un producto nuevo
+    }
+    Posiciones &posiciones = iit->second;
+    // En una estantería ordenada, los ítems nuevos van al final; sólo siguen
+    // en orden si el último ítem ya era de este producto.
+    if (elementos > 0 and estanteria[elementos - 1] != producto) {
+        ordenada = false;
+    }
     elementos += anadir;
     cantidad -= anadir;
 
-    Estanteria::iterator it;
-    for (it = estanteria.begin(); anadir > 0; ++it) {
-        assert(it != estanteria.end());
-        if (it->empty()) {
-            *it = producto;
-            --anadir;
-        }
+    // Ocupa los huecos de menor índice, en orden
+    for (; anadir > 0; --anadir) {
+        assert(not libres.empty());
+        pop_heap(libres.begin(), libres.end(), greater<int>());
+        int pos = libres.back();
+        libres.pop_back();
+        assert(estanteria[pos] == NINGUN_PRODUCTO);
+        estanteria[pos] = producto;
+        posiciones.push_back(pos);
+        push_heap(posiciones.begin(), posiciones.end(), greater<int>());
     }
     return cantidad;
 }
 
-int Sala::quitar_items(IdProducto producto, int cantidad) {
+int Sala::quitar_items(Producto producto, int cantidad) {
     assert(cantidad >= 0);
-    Inventario::iterator iit = inventario.find(producto);
+    InventarioSala::iterator iit = inventario.find(producto);
     if (iit == inventario.end())
         return cantidad; // No hay ningún ítem en esta sala
 
     // Determina el número de elementos a quitar
-    int quitar = min(cantidad, iit->second);
+    Posiciones &posiciones = iit->second;
+    int quitar = min(cantidad, int(posiciones.size()));
     cantidad -= quitar;
-    iit->second -= quitar;
     elementos -= quitar;
 
-    Estanteria::iterator eit;
-    for (eit = estanteria.begin(); quitar > 0; ++eit) {
-        assert(eit != estanteria.end());
-        if (*eit == producto) {
-            *eit = "";
-            --quitar;
-        }
+    // Libera las posiciones de menor índice del producto, en orden
+    for (; quitar > 0; --quitar) {
+        pop_heap(posiciones.begin(), posiciones.end(), greater<int>());
+        int pos = posiciones.back();
+        posiciones.pop_back();
+        assert(estanteria[pos] == producto);
+        estanteria[pos] = NINGUN_PRODUCTO;
+        libres.push_back(pos);
+        push_heap(libres.begin(), libres.end(), greater<int>());
     }
 
-    if (iit->second == 0) {
+    if (posiciones.empty()) {
         inventario.erase(iit); // Elimina las entradas sin productos
+        orden.valido = false;
     }
+    // Quitar ítems no desordena el resto, pero puede dejar huecos
+    ordenada = ordenada and compactada();
     return cantidad;
 }
 
+void Sala::aplicar_lote(const vector<OperacionSala> &operaciones,
+                        vector<int> &resultados) {
+    resultados.resize(operaciones.size());
+    for (int i = 0; i < operaciones.size(); ++i) {
+        const OperacionSala &op = operaciones[i];
+        resultados[i] = op.poner ? poner_items(op.producto, op.cantidad)
+                                 : quitar_items(op.producto, op.cantidad);
+    }
+}
+
 void Sala::compactar() {
-    if (elementos == filas * columnas)
-        return; // Estantería llena, no es necesario compactar
+    if (compactada()) return; // No es necesario compactar (p.ej. llena)
+    // destino[i] es la posición final del ítem que está en la posición i
+    vector<int> destino(estanteria.size(), -1);
     Estanteria::iterator it_done = estanteria.begin();
     Estanteria::iterator it_op = estanteria.begin();
     int procesados = 0;
@@ -93,18 +157,47 @@ void Sala::compactar() {
     //  - [it_op, end) contiene los elementos no procesados
     while (procesados < elementos) {
         assert(it_op != estanteria.end() and it_done != estanteria.end());
-        if (not it_op->empty()) {
-            assert(it_op == it_done or *it_done == "");
+        if (*it_op != NINGUN_PRODUCTO) {
+            assert(it_op == it_done or *it_done == NINGUN_PRODUCTO);
             swap(*it_op, *it_done);
+            destino[it_op - estanteria.begin()] = procesados;
             ++it_done;
             ++procesados;
         }
         ++it_op;
     }
+    reconstruir_libres();
+
+    // La compactación conserva el orden relativo de los ítems, así que
+    // sustituir cada posición por su destino mantiene los montículos válidos.
+    InventarioSala::iterator iit;
+    for (iit = inventario.begin(); iit != inventario.end(); ++iit) {
+        Posiciones &posiciones = iit->second;
+        for (int i = 0; i < posiciones.size(); ++i) {
+            assert(destino[posiciones[i]] != -1);
+            posiciones[i] = destino[posiciones[i]];
+        }
+    }
 }
 
-void Sala::reorganizar() {
-    sort(estanteria.begin(), estanteria.end(), comp_IdProducto);
+void Sala::reorganizar(const Catalogo &catalogo) {
+    if (ordenada) return; // Nada ha cambiado desde la última vez
+    // Reescribe la estantería a partir del inventario ordenado: cada producto
+    // ocupa un bloque consecutivo, sin comparar las posiciones entre ellas.
+    const vector<Producto> &ordenado = inventario_ordenado(catalogo);
+    int pos = 0;
+    for (int k = 0; k < ordenado.size(); ++k) {
+        Producto producto = ordenado[k];
+        Posiciones &posiciones = inventario.find(producto)->second;
+        for (int i = 0; i < posiciones.size(); ++i) {
+            estanteria[pos] = producto;
+            posiciones[i] = pos++;
+        }
+    }
+    assert(pos == elementos);
+    fill(estanteria.begin() + pos, estanteria.end(), NINGUN_PRODUCTO);
+    reconstruir_libres();
+    ordenada = true;
 }
 
 bool Sala::redimensionar(int filas, int columnas) {
@@ -113,7 +206,8 @@ bool Sala::redimensionar(int filas, int columnas) {
     if (nuevo_tamano < elementos)
         return false; // No cabrían los elementos actuales
     compactar();
-    estanteria.resize(nuevo_tamano, "");
+    estanteria.resize(nuevo_tamano, NINGUN_PRODUCTO);
+    reconstruir_libres();
     this->filas = filas;
     this->columnas = columnas;
     return true;
@@ -123,37 +217,117 @@ bool Sala::redimensionar(int filas, int columnas) {
  | Consultores |
  +-------------*/
 
-IdProducto Sala::consultar_pos(int f, int c) const {
+Producto Sala::consultar_pos(int f, int c) const {
     assert(0 < f and f <= filas);
     assert(0 < c and c <= columnas);
     int i = filas - f;
     int j = c - 1;
-    IdProducto p = estanteria[i * columnas + j];
-    if (p.empty()) return "NULL";
-    return p;
+    return estanteria[i * columnas + j];
+}
+
+bool Sala::posicion_valida(int f, int c) const {
+    return 0 < f and f <= filas and 0 < c and c <= columnas;
+}
+
+int Sala::espacio_libre() const {
+    return filas * columnas - elementos;
+}
+
+int Sala::num_filas() const {
+    return filas;
+}
+
+int Sala::num_columnas() const {
+    return columnas;
+}
+
+const InventarioSala &Sala::consultar_inventario() const {
+    return inventario;
 }
 
 /*-----+
  | I/O |
  +-----*/
 
-void Sala::escribir(ostream &os) const {
+void Sala::escribir(ostream &os, const Catalogo &catalogo) const {
     for (int i = filas - 1; i >= 0; --i) {
         os << ' ';
         for (int j = 0; j < columnas; ++j) {
-            IdProducto id_producto = estanteria[i * columnas + j];
-            if (id_producto.empty()) {
+            Producto producto = estanteria[i * columnas + j];
+            if (producto == NINGUN_PRODUCTO) {
                 os << " NULL";
             } else {
-                os << ' ' << id_producto;
+                os << ' ' << catalogo.nombre(producto);
             }
         }
-        os << endl;
+        os << '\n';
+    }
+    const vector<Producto> &ordenado = inventario_ordenado(catalogo);
+    os << "  " << elementos << '\n';
+    for (int k = 0; k < ordenado.size(); ++k) {
+        Producto producto = ordenado[k];
+        os << "  " << catalogo.nombre(producto) << ' '
+           << inventario.find(producto)->second.size() << '\n';
+    }
+}
+
+void Sala::escribir_posiciones(ostream &os, Producto producto) const {
+    InventarioSala::const_iterator it = inventario.find(producto);
+    if (it == inventario.end()) return;
+    const Posiciones &posiciones = it->second;
+    for (int k = 0; k < posiciones.size(); ++k) {
+        int i = posiciones[k] / columnas, j = posiciones[k] % columnas;
+        os << ' ' << filas - i << ',' << j + 1;
     }
-    Inventario::const_iterator it = inventario.begin();
-    os << "  " << elementos << endl;
-    while (it != inventario.end()) {
-        os << "  " << it->first << ' ' << it->second << endl;
-        ++it;
+}
+
+void Sala::guardar(ostream &os) const {
+    escribir_binario(os, filas);
+    escribir_binario(os, columnas);
+    escribir_binario(os, char(ordenada));
+    escribir_binario(os, estanteria.data(), estanteria.size());
+}
+
+bool Sala::cargar(LectorBinario &lector, const Catalogo &catalogo) {
+    Sala nueva;
+    char ordenada;
+    if (not(lector.leer(nueva.filas) and lector.leer(nueva.columnas) and
+            lector.leer(ordenada)))
+        return false;
+    if (nueva.filas <= 0 or nueva.columnas <= 0 or
+        nueva.filas > (1 << 30) / nueva.columnas or
+        nueva.filas * nueva.columnas > lector.restantes() / sizeof(Producto))
+        return false;
+    nueva.estanteria.resize(nueva.filas * nueva.columnas);
+    if (not lector.leer(nueva.estanteria.data(), nueva.estanteria.size()))
+        return false;
+
+    // Las posiciones se recorren en orden creciente, así que los vectores de
+    // posiciones resultantes ya son montículos de mínimos.
+    nueva.elementos = 0;
+    InventarioSala::iterator anterior = nueva.inventario.end();
+    for (int i = 0; i < nueva.estanteria.size(); ++i) {
+        Producto producto = nueva.estanteria[i];
+        if (producto == NINGUN_PRODUCTO) {
+            nueva.libres.push_back(i);
+            continue;
+        }
+        if (anterior == nueva.inventario.end() or anterior->first != producto) {
+            if (producto < 0 or producto >= catalogo.max_codigo() or
+                not catalogo.existe(producto))
+                return false;
+            // La marca guardada no basta: cada producto debe ocupar un solo
+            // bloque, en orden alfabético
+            if (ordenada and anterior != nueva.inventario.end() and
+                not(catalogo.nombre(anterior->first) <
+                    catalogo.nombre(producto)))
+                ordenada = false;
+            anterior = nueva.inventario.insert({producto, Posiciones()}).first;
+        }
+        anterior->second.push_back(i);
+        ++nueva.elementos;
     }
+    nueva.ordenada = ordenada and nueva.compactada();
+    *this = move(nueva);
+    return true;
 }
@@ -1,13 +1,15 @@
 /** @file
  * Archivo que define Sala y estructuras auxiliares, como @ref Estanteria,
- * @ref IdProducto e @ref IdSala.
+ * @ref Posiciones e @ref IdSala.
  */
 
 #ifndef SALA_HH
 #define SALA_HH
 
+#include "Catalogo.hh"
 #include "aux.hh"
 #ifndef NO_DIAGRAM
+#    include <mutex>
 #    include <ostream>
 #    include <vector>
 #endif
@@ -17,16 +19,40 @@ using namespace std;
 /// Identificador de una sala.
 typedef int IdSala;
 
-/** Estantería, representada como un vector de identificadores de productos.
+/** Estantería, representada como un vector de códigos de productos.
  *
  * Este vector puede ser representado como una matriz, donde la posición @f$ (i,
  * j) @f$ está en la posición @f$ i \cdot N + j @f$ donde @f$ N @f$ es el número
  * de columnas.
  *
  * Se ha escogido este formato ya que simplifica la operación reorganizar() y,
- * en menor medida, redimensionar() y compactar().
+ * en menor medida, redimensionar() y compactar(). Las posiciones vacías
+ * contienen @ref NINGUN_PRODUCTO.
  */
-typedef vector<IdProducto> Estanteria;
+typedef vector<Producto> Estanteria;
+
+/** Posiciones de una estantería ocupadas por un producto.
+ *
+ * Los índices (ver @ref Estanteria) están organizados como un montículo de
+ * mínimos (con std::greater), de forma que la posición más baja es siempre la
+ * primera.
+ */
+typedef vector<int> Posiciones;
+
+/** Inventario de una sala, representado como un map [código de producto
+ * &rarr; posiciones]
+ */
+typedef map<Producto, Posiciones> InventarioSala;
+
+/// Operación de un lote sobre una sala (ver Sala::aplicar_lote).
+struct OperacionSala {
+    /// Código del producto.
+    Producto producto;
+    /// Cantidad de ítems (>= 0).
+    int cantidad;
+    /// Si se ponen (@c true) o se quitan (@c false) los ítems.
+    bool poner;
+};
 
 /** Representación de una sala.
  *
@@ -43,17 +69,33 @@ private:
      */
     Estanteria estanteria;
 
-    /** Inventario de la sala.
+    /** Inventario de la sala, con las posiciones que ocupa cada producto.
      *
      * Aunque no es estrictamente necesario, el uso de un inventario hace que la
-     * operación escribir() vaya notablemente más rápido.
+     * operación escribir() vaya notablemente más rápido. Guardar las posiciones
+     * (en lugar de sólo la cantidad) permite que quitar_items() no tenga que
+     * recorrer la estantería.
      *
      * @invariant
-     * @ref inventario cuenta los ítems actuales de @ref estanteria según el
-     * producto. Un producto está en @ref inventario si y sólo si hay al menos
-     * una unidad en @ref estanteria.
+     * Para cada producto de @ref inventario, sus @ref Posiciones son
+     * exactamente los índices de @ref estanteria que contienen el producto, y
+     * su tamaño es el número de ítems del producto en la sala. Un producto está
+     * en @ref inventario si y sólo si hay al menos una unidad en @ref
+     * estanteria.
      */
-    Inventario inventario;
+    InventarioSala inventario;
+
+    /** Posiciones libres de la estantería, organizadas como un montículo de
+     * mínimos (con std::greater).
+     *
+     * Permite encontrar el primer hueco de la estantería sin recorrerla desde
+     * el principio.
+     *
+     * @invariant
+     * @ref libres contiene exactamente los índices de los elementos nulos de
+     * @ref estanteria, y cumple la propiedad de montículo de mínimos.
+     */
+    vector<int> libres;
 
     /** Números de elementos en la estantería de la sala.
      * Al igual que @ref inventario, no es necesario, pero agiliza algunas
@@ -62,7 +104,7 @@ private:
      * @invariant
      * Los siguientes son iguales:
      * - El número de ítems no nulos de @ref estanteria.
-     * - La suma de los valores de @ref inventario.
+     * - La suma de los tamaños de las posiciones de @ref inventario.
      * - El valor de @ref elementos.
      *
      * @invariant
@@ -79,24 +121,85 @@ private:
     /// Columnas de la estantería de la sala.
     int columnas;
 
-    /** Comparar dos productos, considerando los productos nulos como mayores al
-     * resto de productos.
+    /** Caché de los productos de @ref inventario por orden alfabético.
+     *
+     * Una sala compartida con las vistas (ver VistaAlmacen) se puede
+     * consultar desde varios hilos a la vez, y todos pueden querer calcular
+     * la caché: por eso tiene un mutex. Por el mismo motivo no se copia con
+     * la sala (se podría estar calculando mientras tanto): la copia empieza
+     * con la caché sin calcular.
+     */
+    struct CacheOrden {
+        /// Protege @ref productos y @ref valido.
+        mutex m;
+        /// Códigos de los productos, si @ref valido.
+        vector<Producto> productos;
+        /// Indica si @ref productos está actualizado.
+        bool valido;
+
+        /// Crea una caché sin calcular.
+        CacheOrden() : valido(false) {}
+
+        /// Crea una caché sin calcular (no copia la otra).
+        CacheOrden(const CacheOrden &) : valido(false) {}
+
+        /// Deja la caché sin calcular (no copia la otra).
+        CacheOrden &operator=(const CacheOrden &) {
+            productos.clear();
+            valido = false;
+            return *this;
+        }
+    };
+
+    /** Productos de @ref inventario por orden alfabético.
+     *
+     * Es una caché: sólo se recalcula (en inventario_ordenado()) cuando entra
+     * o sale algún producto de la sala, no cuando cambia su número de ítems.
+     *
+     * @invariant
+     * Si <tt>orden.valido</tt>, <tt>orden.productos</tt> contiene los códigos
+     * de los productos de @ref inventario, ordenados según su identificador.
+     */
+    mutable CacheOrden orden;
+
+    /** Indica si la estantería está ordenada (y compactada), como la deja
+     * reorganizar().
+     *
+     * Permite que reorganizar() no haga nada si no ha habido cambios desde la
+     * última vez. Las operaciones que lo pueden comprobar en tiempo constante
+     * lo mantienen; el resto lo ponen a @c false.
+     *
+     * @invariant
+     * Si @ref ordenada, compactada() y los ítems de @ref estanteria están
+     * ordenados alfabéticamente.
+     */
+    bool ordenada;
+
+    /** Reconstruye @ref libres a partir de una estantería compactada.
      *
-     * Esta función se puede usar como el tercer argumento de std::sort().
+     * @pre
+     * La estantería está compactada: los @ref elementos primeros ítems de
+     * @ref estanteria son no nulos y el resto son nulos.
      *
-     * @param[in] a, b
-     * Identificadores de producto a comparar.
+     * @post
+     * @ref libres contiene los índices de @ref elementos a @c
+     * estanteria.size() - 1 en orden creciente (que es un montículo válido).
+     *
+     * @cost
+     * Lineal en el número de posiciones libres
+     */
+    void reconstruir_libres();
+
+    /** Indica si la estantería está compactada.
      *
      * @returns
-     * - <tt>a < b</tt> para @c a, @c b != ""
-     * - @c false si a == ""
-     * - @c true si a != "", b == ""
+     * @c true si y sólo si los @ref elementos primeros ítems de @ref
+     * estanteria son no nulos (y, por lo tanto, el resto son nulos).
      *
      * @cost
-     * Hasta lineal en la longitud de a y b (o el coste de
-     * <tt>std::string::operator<</tt>)
+     * Constante
      */
-    static bool comp_IdProducto(const IdProducto &a, const IdProducto &b);
+    bool compactada() const;
 
 public:
     /** Crea una sala vacía.
@@ -124,8 +227,8 @@ public:
 
     /** Poner un ítem de un producto en la sala.
      *
-     * @param id_producto
-     * Identificador del producto.
+     * @param producto
+     * Código del producto.
      *
      * @param cantidad
      * Cantidad de ítems del producto a añadir como máximo.
@@ -134,25 +237,25 @@ public:
      * Cantidad de ítems que no se han podido añadir por falta de espacio.
      *
      * @pre
-     * @c cantidad >= 0; el producto @c id_producto existe.
+     * @c cantidad >= 0; el producto @c producto existe.
      *
      * @post
      * Se han añadido min(`cantidad`, espacio libre en la sala) ítems del
-     * producto @c id_producto a la sala; si @e return > 0 &rArr; sala llena; @b
+     * producto @c producto a la sala; si @e return > 0 &rArr; sala llena; @b
      * NO se han añadido los productos al inventario del almacén.
      *
      * @cost
-     * Lineal en el número de productos añadidos
+     * Linearítmico en el número de productos añadidos
      *
      * @see
      * Almacen::poner_items
      */
-    int poner_items(IdProducto id_producto, int cantidad);
+    int poner_items(Producto producto, int cantidad);
 
     /** Quitar un ítem de un producto de la sala.
      *
-     * @param id_producto
-     * Identificador del producto.
+     * @param producto
+     * Código del producto.
      *
      * @param cantidad
      * Cantidad de ítems del producto a quitar como máximo.
@@ -162,21 +265,43 @@ public:
      * suficientes en la sala.
      *
      * @pre
-     * @c cantidad >= 0; el producto @c id_producto existe.
+     * @c cantidad >= 0; el producto @c producto existe.
      *
      * @post
      * Se han quitado min(`cantidad`, ítems del producto en la sala) ítems del
-     * producto @c id_producto de la sala; si @e return > 0 &rArr; No quedan
+     * producto @c producto de la sala; si @e return > 0 &rArr; No quedan
      * ítems en la sala; @b NO se han quitado los productos del inventario del
      * almacén.
      *
      * @cost
-     * Lineal en el número de elementos quitados
+     * Linearítmico en el número de elementos quitados, logarítmico en el
+     * número de productos de la sala
      *
      * @see
      * Almacen::quitar_items
      */
-    int quitar_items(IdProducto id_producto, int cantidad);
+    int quitar_items(Producto producto, int cantidad);
+
+    /** Aplica un lote de operaciones de poner y quitar ítems, en orden.
+     *
+     * El resultado es el mismo que llamar a poner_items() o quitar_items()
+     * con cada operación. Permite al almacén tratar de una vez todas las
+     * operaciones de un lote sobre la misma sala (ver Almacen::aplicar_lote).
+     *
+     * @param operaciones
+     * Operaciones a aplicar.
+     *
+     * @param[out] resultados
+     * Para cada operación, lo que devolvería poner_items() o quitar_items().
+     *
+     * @pre
+     * Los productos de @c operaciones existen.
+     *
+     * @cost
+     * La suma de los costes de las operaciones
+     */
+    void aplicar_lote(const vector<OperacionSala> &operaciones,
+                      vector<int> &resultados);
 
     /** Compactar la estantería.
      *
@@ -187,7 +312,8 @@ public:
      * La estantería está compactada.
      *
      * @cost
-     * Lineal en el tamaño de la estantería
+     * Constante si ya estaba compactada; lineal en el tamaño de la estantería
+     * si no
      *
      * @see
      * Almacen::compactar
@@ -198,17 +324,22 @@ public:
      *
      * Los productos de la estantería se compactan y se ordenan alfabéticamente.
      *
+     * @param catalogo
+     * Catálogo con los identificadores de los productos de la sala.
+     *
      * @post
      * La estantería está ordenada y compactada.
      *
      * @cost
-     * Linerítmico, de media, en el tamaño de la estantería
+     * Constante si ya estaba ordenada; si no, lineal en el tamaño de la
+     * estantería, logarítmico por cada producto distinto de la sala (más el
+     * coste de ordenar estos productos si han cambiado desde la última vez)
      *
      * @see
      * compactar,
      * Almacen::reorganizar
      */
-    void reorganizar();
+    void reorganizar(const Catalogo &catalogo);
 
     /** Redimensiona la estantería de la sala.
      *
@@ -240,7 +371,7 @@ public:
      * Posición del producto.
      *
      * @returns
-     * El elemento en (f, c) o @c "NULL" si está vacío.
+     * El código del elemento en (f, c) o @ref NINGUN_PRODUCTO si está vacío.
      *
      * @pre
      * 0 < @c f <= Número de filas; 0 < @c c <= Número de columnas.
@@ -251,24 +382,133 @@ public:
      * @see
      * Almacen::consultar_pos
      */
-    IdProducto consultar_pos(int f, int c) const;
+    Producto consultar_pos(int f, int c) const;
+
+    /** Indica si (f, c) es una posición de la estantería.
+     *
+     * @cost
+     * Constante
+     */
+    bool posicion_valida(int f, int c) const;
+
+    /** Consulta el espacio libre de la estantería.
+     *
+     * @returns
+     * El número de posiciones vacías de la estantería.
+     *
+     * @cost
+     * Constante
+     */
+    int espacio_libre() const;
+
+    /// Número de filas de la estantería.
+    int num_filas() const;
+
+    /// Número de columnas de la estantería.
+    int num_columnas() const;
+
+    /** Consulta el inventario de la sala.
+     *
+     * @returns
+     * Las posiciones que ocupa cada producto de la sala (ver @ref
+     * InventarioSala).
+     *
+     * @cost
+     * Constante
+     */
+    const InventarioSala &consultar_inventario() const;
+
+    /** Productos de la sala, por orden alfabético.
+     *
+     * @param catalogo
+     * Catálogo con los identificadores de los productos de la sala.
+     *
+     * @returns
+     * Los productos de @ref orden, recalculados si no eran válidos.
+     *
+     * @cost
+     * Constante si @ref orden es válido; linearítmico en el número de productos
+     * distintos de la sala si no.
+     */
+    const vector<Producto> &inventario_ordenado(const Catalogo &catalogo) const;
 
     /** Escribe la estantería.
      *
      * @param os
      * Stream al que escribir la estantería.
      *
+     * @param catalogo
+     * Catálogo con los identificadores de los productos de la sala.
+     *
      * @post
      * La estantería se ha escrito a @c os tal y como sería realmente (con el
      * (0, 0) en la esquina inferior izquierda).
      *
      * @cost
-     * Lineal en el tamaño de la estantería
+     * Lineal en el tamaño de la estantería, linearítmico en el número de
+     * productos distintos de la sala
      *
      * @see
      * Almacen::escribir
      */
-    void escribir(ostream &os) const;
+    void escribir(ostream &os, const Catalogo &catalogo) const;
+
+    /** Escribe las posiciones que ocupa un producto.
+     *
+     * Escribe, para cada ítem, un espacio y su posición como <tt>f,c</tt>
+     * (igual que en consultar_pos()), en un orden cualquiera.
+     *
+     * @param os
+     * Stream de salida.
+     *
+     * @param producto
+     * Código del producto.
+     *
+     * @cost
+     * Logarítmico en el número de productos de la sala, más lineal en el
+     * número de ítems de @c producto
+     */
+    void escribir_posiciones(ostream &os, Producto producto) const;
+
+    /** Guarda la sala en binario: dimensiones, @ref ordenada y estantería.
+     *
+     * El resto de la representación (@ref inventario, @ref libres...) se
+     * reconstruye al cargarla.
+     *
+     * @param os
+     * Stream de salida.
+     *
+     * @cost
+     * Lineal en el tamaño de la estantería
+     */
+    void guardar(ostream &os) const;
+
+    /** Carga una sala guardada con guardar().
+     *
+     * La marca @ref ordenada guardada no se da por buena: sólo se conserva
+     * si la estantería está compactada y sus ítems están de verdad en orden
+     * alfabético.
+     *
+     * @param lector
+     * Lector del bloque con la sala.
+     *
+     * @param catalogo
+     * Catálogo con los productos de la sala.
+     *
+     * @retval true
+     * Se ha cargado la sala, que sustituye a la anterior.
+     *
+     * @retval false
+     * El bloque no contiene una sala válida con productos de @c catalogo. El
+     * objeto no ha sido modificado.
+     *
+     * @cost
+     * Lineal en el tamaño de la estantería, logarítmico en el número de
+     * productos distintos (más la comparación de dos identificadores, si se
+     * guardó como ordenada) por cada cambio de producto entre posiciones
+     * consecutivas
+     */
+    bool cargar(LectorBinario &lector, const Catalogo &catalogo);
 };
 
 #endif // SALA_HH
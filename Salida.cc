@@ -0,0 +1,84 @@
+/** @file
+ * Implementación de Salida.
+ */
+#include "Salida.hh"
+#ifndef NO_DIAGRAM
+#    include <cassert>
+#    include <cerrno>
+#    include <fcntl.h>
+#    include <unistd.h> // write, fdatasync, fsync
+#endif
+
+/*------------------+
+ | Métodos privados |
+ +------------------*/
+
+bool Salida::vaciar() {
+    if (pptr() == pbase()) return true; // Nada que escribir
+    if (ligado != NULL and not ligado->flush()) return false;
+    const char *p = pbase();
+    while (p < pptr()) {
+        ssize_t escrito = write(fd, p, pptr() - p);
+        if (escrito < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += escrito;
+    }
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return not sincronizar or fdatasync(fd) == 0;
+}
+
+/*---------------------+
+ | Métodos de streambuf |
+ +---------------------*/
+
+Salida::int_type Salida::overflow(int_type c) {
+    if (not vaciar()) return traits_type::eof();
+    if (not traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int Salida::sync() {
+    return vaciar() ? 0 : -1;
+}
+
+/*---------------+
+ | Constructores |
+ +---------------*/
+
+Salida::Salida(int fd, int capacidad, bool sincronizar)
+    : fd(fd), buffer(capacidad), sincronizar(sincronizar), ligado(NULL) {
+    assert(capacidad > 0);
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+Salida::~Salida() {
+    vaciar();
+}
+
+/*------------------+
+ | Métodos públicos |
+ +------------------*/
+
+void Salida::ligar(ostream *os) {
+    ligado = os;
+}
+
+/*-----------+
+ | Funciones |
+ +-----------*/
+
+bool sincronizar_directorio(const string &fichero) {
+    string::size_type barra = fichero.rfind('/');
+    string directorio = barra == string::npos ? "."
+                        : barra == 0          ? "/"
+                                              : fichero.substr(0, barra);
+    int fd = open(directorio.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    return close(fd) == 0 and ok;
+}
@@ -0,0 +1,112 @@
+/** @file
+ * Archivo que define Salida.
+ */
+
+#ifndef SALIDA_HH
+#define SALIDA_HH
+
+#ifndef NO_DIAGRAM
+#    include <ostream>
+#    include <streambuf>
+#    include <string>
+#    include <vector>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Buffer de salida sobre un descriptor de fichero.
+ *
+ * Acumula todo lo que se escribe y sólo llama a @c write(2) cuando el buffer
+ * está lleno o cuando se vacía explícitamente (p.ej. con @c flush o @c endl).
+ * Se usa como @c rdbuf de @c cout para que las respuestas de muchas
+ * instrucciones se escriban con una sola llamada al sistema.
+ */
+class Salida : public streambuf {
+private:
+    /// Descriptor en el que se escribe.
+    int fd;
+
+    /** Contenido pendiente de escribir.
+     *
+     * @invariant
+     * El área de escritura del @c streambuf (@c pbase() a @c epptr()) es
+     * @c buffer entero.
+     */
+    vector<char> buffer;
+
+    /// Indica si se sincroniza con el disco (@c fdatasync) tras cada escritura.
+    bool sincronizar;
+
+    /// Stream que se vacía antes de cada escritura en @ref fd (o NULL).
+    ostream *ligado;
+
+    /** Escribe el contenido pendiente en @ref fd (antes vacía @ref ligado y,
+     * después, si @ref sincronizar, espera a que los datos lleguen al disco).
+     *
+     * @retval true
+     * Se ha escrito todo; el buffer está vacío.
+     *
+     * @retval false
+     * Ha habido un error de escritura.
+     *
+     * @cost
+     * Lineal en el contenido pendiente
+     */
+    bool vaciar();
+
+protected:
+    /// Vacía el buffer y guarda @c c (si no es EOF).
+    int_type overflow(int_type c);
+
+    /// Vacía el buffer; devuelve -1 si hay algún error.
+    int sync();
+
+public:
+    /** Crea un buffer de salida.
+     *
+     * @param fd
+     * Descriptor en el que se escribirá.
+     *
+     * @param capacidad
+     * Tamaño del buffer, en bytes.
+     *
+     * @param sincronizar
+     * Si cada escritura debe esperar a que los datos lleguen al disco (con
+     * @c fdatasync), como en un diario.
+     *
+     * @pre
+     * @c capacidad > 0.
+     */
+    Salida(int fd, int capacidad, bool sincronizar = false);
+
+    /** Liga un stream a la salida: se vaciará antes de cada escritura en el
+     * descriptor (como hace Lector::ligar con las lecturas).
+     *
+     * Así, si se liga un diario a la salida estándar, ninguna respuesta se
+     * escribe antes de que las instrucciones que la han producido estén
+     * guardadas en el diario.
+     *
+     * @param os
+     * Stream a ligar, o NULL para no ligar ninguno.
+     */
+    void ligar(ostream *os);
+
+    /// Vacía el buffer antes de destruirlo.
+    ~Salida();
+};
+
+/** Sincroniza con el disco el directorio que contiene @c fichero (con
+ * @c fsync), para que su creación, su sustitución con @c rename o su borrado
+ * no se pierdan en una caída: @c fsync sobre el propio fichero sólo garantiza
+ * su contenido.
+ *
+ * @param fichero
+ * Ruta de un fichero del directorio (relativa al directorio actual si no
+ * tiene ninguna barra).
+ *
+ * @retval false
+ * No se ha podido abrir o sincronizar el directorio.
+ */
+bool sincronizar_directorio(const string &fichero);
+
+#endif // SALIDA_HH
@@ -0,0 +1,317 @@
+/** @file
+ * Implementación de Servidor.
+ */
+#include "Servidor.hh"
+#include "Lector.hh"
+#ifndef NO_DIAGRAM
+#    include <cassert>
+#    include <cerrno>
+#    include <chrono>
+#    include <csignal>
+#    include <cstring>
+#    include <fcntl.h>
+#    include <sys/epoll.h>
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+/// Número máximo de eventos que se atienden en cada vuelta del bucle.
+static const int MAX_EVENTOS = 256;
+
+/// Tamaño de los bloques que se leen de los sockets.
+static const int TAM_BLOQUE = 1 << 16;
+
+/** Longitud máxima de una instrucción: con más datos sin un salto de línea
+ * que la termine, se cierra la conexión.
+ */
+static const int MAX_ENTRADA = 1 << 20;
+
+/** Respuestas pendientes de enviar a partir de las cuales no se leen más
+ * instrucciones de un cliente.
+ */
+static const int MAX_PENDIENTE = 1 << 20;
+
+/// Indica que se ha recibido @c SIGINT o @c SIGTERM.
+static volatile sig_atomic_t parar = 0;
+
+/// Manejador de @c SIGINT y @c SIGTERM.
+static void al_parar(int) {
+    parar = 1;
+}
+
+/// Pone un descriptor en modo no bloqueante.
+static bool no_bloqueante(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    return flags >= 0 and fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/*------------------+
+ | Métodos privados |
+ +------------------*/
+
+void Servidor::aceptar() {
+    while (true) {
+        int fd = accept(escucha, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN: no quedan conexiones (o error)
+        }
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (not no_bloqueante(fd) or
+            epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+        if (fd >= clientes.size()) clientes.resize(fd + 1);
+        clientes[fd].reset(new Cliente());
+        clientes[fd]->fd = fd;
+        clientes[fd]->num_comandos = 0;
+        clientes[fd]->eventos = EPOLLIN;
+        clientes[fd]->terminado = false;
+    }
+}
+
+void Servidor::recibir(Cliente &cliente) {
+    if (cliente.terminado) return; // Sólo queda enviarle lo pendiente
+    char bloque[TAM_BLOQUE];
+    // Si se llega al máximo, el resto se lee en otra vuelta del bucle
+    while (cliente.entrada.size() < MAX_ENTRADA) {
+        ssize_t leido = read(cliente.fd, bloque, sizeof bloque);
+        if (leido > 0) {
+            cliente.entrada.append(bloque, leido);
+            continue;
+        }
+        if (leido < 0 and errno == EINTR) continue;
+        if (leido == 0 or errno != EAGAIN) cliente.terminado = true;
+        break;
+    }
+    if (cliente.terminado and cliente.entrada.empty()) return;
+
+    // Sólo las líneas completas (o todo, si el cliente ha cerrado); se
+    // conserva el resto
+    size_t final = cliente.entrada.size();
+    if (not cliente.terminado) {
+        final = cliente.entrada.rfind('\n');
+        if (final == string::npos) {
+            if (cliente.entrada.size() >= MAX_ENTRADA) {
+                cliente.terminado = true;
+                cliente.entrada.clear();
+            }
+            return;
+        }
+        ++final;
+    }
+    Lector lector(cliente.entrada.data(), final);
+    int consumido = 0;
+    while (true) {
+        if (cliente.num_comandos == cliente.comandos.size()) {
+            cliente.comandos.push_back(Comando());
+        }
+        Comando &comando = cliente.comandos[cliente.num_comandos];
+        if (not leer_comando(lector, comando)) {
+            // Si quedan palabras, la instrucción está mal formada; si no,
+            // puede seguir en una línea que aún no ha llegado.
+            Token token;
+            if (lector.leer(token)) {
+                cliente.terminado = true;
+                consumido = cliente.entrada.size();
+            }
+            break;
+        }
+        consumido = lector.posicion();
+        ++cliente.num_comandos;
+    }
+    cliente.entrada.erase(0, consumido);
+    if (cliente.entrada.size() >= MAX_ENTRADA) {
+        cliente.terminado = true;
+        cliente.entrada.clear();
+    }
+}
+
+int Servidor::ejecutar(Cliente &cliente, Estadisticas &estadisticas) {
+    Resultado resultado;
+    int ejecutadas = 0;
+    for (int i = 0; i < cliente.num_comandos; ++i) {
+        const Comando &comando = cliente.comandos[i];
+        if (comando.tipo == FIN) {
+            // No se ejecuta nada más, aunque el cliente lo haya enviado
+            respuesta << "fin" << '\n';
+            cliente.terminado = true;
+            cliente.entrada.clear();
+            break;
+        }
+        escribir_eco(respuesta, comando);
+        if (not comando_valido(almacen, comando)) {
+            // Las instrucciones de cada cliente pueden haber dejado de
+            // cumplir sus precondiciones por las de otro (p.ej. tras un
+            // redimensionar)
+            estadisticas.contar(comando.tipo);
+            respuesta << "  error" << '\n';
+            ++ejecutadas;
+            continue;
+        }
+        if (comando.tipo == ESTADISTICAS) {
+            estadisticas.contar(comando.tipo);
+            estadisticas.escribir(respuesta, almacen.consultar_trabajo());
+        } else if (comando.tipo == PUNTO_CONTROL) {
+            estadisticas.contar(comando.tipo);
+            resultado.valor = 0; // No hay diario
+        } else if (medir) {
+            chrono::steady_clock::time_point inicio =
+                chrono::steady_clock::now();
+            ::ejecutar(almacen, comando, resultado, respuesta);
+            chrono::nanoseconds ns = chrono::steady_clock::now() - inicio;
+            estadisticas.registrar(comando.tipo, ns.count());
+        } else {
+            ::ejecutar(almacen, comando, resultado, respuesta);
+            estadisticas.contar(comando.tipo);
+        }
+        escribir_resultado(respuesta, comando, resultado);
+        ++ejecutadas;
+    }
+    cliente.num_comandos = 0;
+    if (respuesta.tellp() > 0) {
+        cliente.salida += respuesta.str();
+        respuesta.str(string());
+    }
+    return ejecutadas;
+}
+
+bool Servidor::enviar(Cliente &cliente) {
+    size_t enviado = 0;
+    while (enviado < cliente.salida.size()) {
+        ssize_t n = send(cliente.fd, cliente.salida.data() + enviado,
+                         cliente.salida.size() - enviado, MSG_NOSIGNAL);
+        if (n > 0) {
+            enviado += n;
+        } else if (n < 0 and errno == EINTR) {
+            continue;
+        } else if (n < 0 and errno == EAGAIN) {
+            break;
+        } else {
+            // El cliente ya no está: se descarta lo que quede
+            cliente.salida.clear();
+            enviado = 0;
+            cliente.terminado = true;
+            break;
+        }
+    }
+    cliente.salida.erase(0, enviado);
+
+    if (cliente.salida.empty() and cliente.terminado) {
+        cerrar(cliente);
+        return false;
+    }
+    unsigned eventos = 0;
+    if (not cliente.terminado and cliente.salida.size() < MAX_PENDIENTE) {
+        eventos |= EPOLLIN;
+    }
+    if (not cliente.salida.empty()) eventos |= EPOLLOUT;
+    if (eventos != cliente.eventos) {
+        epoll_event ev;
+        ev.events = eventos;
+        ev.data.fd = cliente.fd;
+        epoll_ctl(epoll, EPOLL_CTL_MOD, cliente.fd, &ev);
+        cliente.eventos = eventos;
+    }
+    return true;
+}
+
+void Servidor::cerrar(Cliente &cliente) {
+    int fd = cliente.fd;
+    epoll_ctl(epoll, EPOLL_CTL_DEL, fd, NULL);
+    close(fd);
+    clientes[fd].reset();
+}
+
+/*---------------+
+ | Constructores |
+ +---------------*/
+
+Servidor::Servidor(Almacen &almacen, const string &ruta, bool medir)
+    : almacen(almacen), ruta(ruta), medir(medir), escucha(-1), epoll(-1) {}
+
+Servidor::~Servidor() {
+    for (unique_ptr<Cliente> &cliente : clientes) {
+        if (cliente) cerrar(*cliente);
+    }
+    if (epoll >= 0) close(epoll);
+    if (escucha >= 0) {
+        close(escucha);
+        unlink(ruta.c_str());
+    }
+}
+
+/*------------------+
+ | Métodos públicos |
+ +------------------*/
+
+bool Servidor::escuchar() {
+    sockaddr_un direccion;
+    memset(&direccion, 0, sizeof direccion);
+    direccion.sun_family = AF_UNIX;
+    if (ruta.size() >= sizeof direccion.sun_path) return false;
+    strcpy(direccion.sun_path, ruta.c_str());
+
+    escucha = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (escucha < 0) return false;
+    unlink(ruta.c_str());
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = escucha;
+    epoll = epoll_create1(0);
+    if (bind(escucha, reinterpret_cast<sockaddr *>(&direccion),
+             sizeof direccion) != 0 or
+        listen(escucha, SOMAXCONN) != 0 or not no_bloqueante(escucha) or
+        epoll < 0 or epoll_ctl(epoll, EPOLL_CTL_ADD, escucha, &ev) != 0) {
+        close(escucha);
+        escucha = -1;
+        return false;
+    }
+    return true;
+}
+
+long long Servidor::ejecutar(Estadisticas &estadisticas) {
+    assert(escucha >= 0);
+    // Sin SA_RESTART, para que epoll_wait() vuelva al recibir la señal
+    struct sigaction accion;
+    memset(&accion, 0, sizeof accion);
+    accion.sa_handler = al_parar;
+    sigaction(SIGINT, &accion, NULL);
+    sigaction(SIGTERM, &accion, NULL);
+
+    long long ejecutadas = 0;
+    epoll_event eventos[MAX_EVENTOS];
+    vector<int> listos;
+    while (not parar) {
+        int n = epoll_wait(epoll, eventos, MAX_EVENTOS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Recibir de todos los clientes listos...
+        listos.clear();
+        for (int i = 0; i < n; ++i) {
+            int fd = eventos[i].data.fd;
+            if (fd == escucha) {
+                aceptar();
+            } else if (clientes[fd]) {
+                if (eventos[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    recibir(*clientes[fd]);
+                }
+                listos.push_back(fd);
+            }
+        }
+        // ... ejecutar sus instrucciones en bloque...
+        for (int fd : listos) {
+            ejecutadas += ejecutar(*clientes[fd], estadisticas);
+        }
+        // ... y enviar las respuestas de cada uno de una vez
+        for (int fd : listos) enviar(*clientes[fd]);
+    }
+    return ejecutadas;
+}
@@ -0,0 +1,160 @@
+/** @file
+ * Archivo que define Servidor.
+ */
+
+#ifndef SERVIDOR_HH
+#define SERVIDOR_HH
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#include "Estadisticas.hh"
+#ifndef NO_DIAGRAM
+#    include <memory>
+#    include <sstream>
+#    include <string>
+#    include <vector>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Servidor de un Almacen para muchos clientes por un socket Unix.
+ *
+ * Cada cliente habla el mismo protocolo de texto que la entrada estándar:
+ * envía instrucciones y recibe su eco, su listado y su resultado, hasta que
+ * envía @c fin (se le responde @c fin y se cierra la conexión) o cierra la
+ * conexión.
+ *
+ * Un solo hilo atiende a todos los clientes con un bucle de eventos
+ * (@c epoll), con sockets no bloqueantes. En cada vuelta del bucle se leen
+ * los datos de todos los clientes que tienen datos, se ejecutan en bloque
+ * sus instrucciones completas y se envían las respuestas de cada cliente de
+ * una vez. Las instrucciones de cada cliente se ejecutan y se responden en
+ * el orden en que las ha enviado; las de clientes distintos se intercalan
+ * según llegan. Mientras un cliente tiene muchas respuestas sin recibir, no
+ * se leen más instrucciones suyas.
+ *
+ * Las instrucciones @ref ESTADISTICAS y @ref PUNTO_CONTROL se ejecutan como
+ * en main(), sin diario. Como los clientes no se conocen entre sí, no se
+ * confía en que sus instrucciones cumplan las precondiciones: si alguna no
+ * las cumple en el estado actual del almacén (ver comando_valido()), se
+ * responde <tt>  error</tt> sin ejecutarla.
+ */
+class Servidor {
+private:
+    /// Estado de una conexión.
+    struct Cliente {
+        /// Descriptor del socket.
+        int fd;
+        /// Datos recibidos que todavía no forman una instrucción completa.
+        string entrada;
+        /// Instrucciones completas pendientes de ejecutar.
+        vector<Comando> comandos;
+        /// Número de instrucciones válidas de @ref comandos.
+        int num_comandos;
+        /// Respuestas de las instrucciones ejecutadas, sin enviar.
+        string salida;
+        /// Eventos de @c epoll para los que está registrado @ref fd.
+        unsigned eventos;
+        /** Indica que la conexión se cerrará en cuanto se haya enviado
+         * @ref salida (el cliente ha enviado @c fin o ha cerrado).
+         */
+        bool terminado;
+    };
+
+    /// Almacén sobre el que se ejecutan las instrucciones.
+    Almacen &almacen;
+    /// Ruta del socket.
+    string ruta;
+    /// Si se mide la latencia de cada instrucción.
+    bool medir;
+    /// Socket en el que se aceptan las conexiones (o -1).
+    int escucha;
+    /// Descriptor de @c epoll (o -1).
+    int epoll;
+    /// Clientes conectados, indexados por el descriptor de su socket.
+    vector<unique_ptr<Cliente> > clientes;
+    /// Stream en el que se escriben las respuestas, reutilizado.
+    ostringstream respuesta;
+
+    /// Acepta todas las conexiones pendientes.
+    void aceptar();
+
+    /** Lee todos los datos disponibles de un cliente y separa sus
+     * instrucciones completas en @ref Cliente::comandos.
+     *
+     * Sólo se interpretan las líneas completas (una instrucción puede
+     * continuar en la línea siguiente). Si una instrucción está mal formada
+     * (p.ej. un número que no lo es) o se acumula 1 MiB sin completar
+     * ninguna, se cierra la conexión después de responder a las
+     * anteriores.
+     */
+    void recibir(Cliente &cliente);
+
+    /** Ejecuta las instrucciones pendientes de un cliente y añade sus
+     * respuestas a @ref Cliente::salida.
+     *
+     * @param estadisticas
+     * Estadísticas en las que se cuentan las instrucciones.
+     *
+     * @returns
+     * El número de instrucciones ejecutadas.
+     */
+    int ejecutar(Cliente &cliente, Estadisticas &estadisticas);
+
+    /** Envía lo que se pueda de @ref Cliente::salida sin bloquear y, si ya
+     * se ha enviado todo y el cliente ha terminado, cierra la conexión. Si
+     * no, actualiza los eventos que se esperan del cliente: escribir si
+     * queda algo por enviar, y leer si no queda demasiado.
+     *
+     * @returns
+     * @c false si se ha cerrado la conexión.
+     */
+    bool enviar(Cliente &cliente);
+
+    /// Cierra la conexión de un cliente.
+    void cerrar(Cliente &cliente);
+
+public:
+    /** Crea un servidor (sin abrir el socket).
+     *
+     * @param almacen
+     * Almacén que servirá.
+     *
+     * @param ruta
+     * Ruta del socket Unix.
+     *
+     * @param medir
+     * Si se mide la latencia de cada instrucción (ver Estadisticas).
+     */
+    Servidor(Almacen &almacen, const string &ruta, bool medir);
+
+    /// Cierra todas las conexiones y borra el socket.
+    ~Servidor();
+
+    /** Crea el socket en @ref ruta (sustituyendo uno anterior) y empieza a
+     * escuchar.
+     *
+     * @retval true
+     * El servidor está listo para atender clientes.
+     *
+     * @retval false
+     * No se ha podido crear el socket.
+     */
+    bool escuchar();
+
+    /** Atiende a los clientes hasta que el proceso recibe @c SIGINT o
+     * @c SIGTERM.
+     *
+     * @param estadisticas
+     * Estadísticas en las que se cuentan las instrucciones.
+     *
+     * @returns
+     * El número de instrucciones ejecutadas.
+     *
+     * @pre
+     * Se ha llamado a escuchar() con éxito.
+     */
+    long long ejecutar(Estadisticas &estadisticas);
+};
+
+#endif // SERVIDOR_HH
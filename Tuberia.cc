@@ -0,0 +1,140 @@
+/** @file
+ * Implementación de Tuberia.
+ */
+#include "Tuberia.hh"
+#ifndef NO_DIAGRAM
+#    include <cassert>
+#    include <chrono>
+#    include <thread>
+#endif
+
+/*------------------+
+ | Métodos privados |
+ +------------------*/
+
+/** Veces que se cede el núcleo esperando a un contador antes de
+ * bloquearse.
+ */
+static const int MAX_CESIONES = 64;
+
+void Tuberia::esperar(Contador &contador, long long valor) {
+    // Con menos núcleos que hilos, ceder el núcleo es lo que hace avanzar
+    // al otro hilo.
+    for (int i = 0; i < MAX_CESIONES; ++i) {
+        if (contador.valor.load(memory_order_acquire) > valor) return;
+        this_thread::yield();
+    }
+    // El otro hilo está parado (p.ej. esperando la entrada): se bloquea.
+    // Como bloqueados y valor son seq_cst, o avanzar() ve el hilo
+    // bloqueado, o el hilo ve el valor nuevo antes de esperar.
+    unique_lock<mutex> lock(contador.m);
+    ++contador.bloqueados;
+    while (contador.valor.load() <= valor) contador.cambio.wait(lock);
+    --contador.bloqueados;
+}
+
+void Tuberia::avanzar(Contador &contador, long long valor) {
+    contador.valor.store(valor);
+    if (contador.bloqueados.load() > 0) {
+        lock_guard<mutex> lock(contador.m);
+        contador.cambio.notify_all();
+    }
+}
+
+void Tuberia::leer() {
+    long long capacidad = mascara + 1;
+    for (long long i = 0;; ++i) {
+        // El paso i reutiliza el del paso i - capacidad: tiene que estar
+        // escrito
+        esperar(escritos, i - capacidad);
+        Paso &paso = pasos[i & mascara];
+        bool fin = not leer_comando(lector, paso.comando) or
+                   paso.comando.tipo == FIN;
+        paso.fin = fin;
+        avanzar(leidos, i + 1);
+        if (fin) return;
+    }
+}
+
+void Tuberia::escribir() {
+    for (long long i = 0;; ++i) {
+        esperar(ejecutados, i);
+        const Paso &paso = pasos[i & mascara];
+        if (paso.fin) {
+            avanzar(escritos, i + 1);
+            return;
+        }
+        escribir_eco(os, paso.comando);
+        os << paso.listado;
+        escribir_resultado(os, paso.comando, paso.resultado);
+        avanzar(escritos, i + 1);
+        if (ventana > 0 and (i + 1) % ventana == 0) os.flush();
+    }
+}
+
+void Tuberia::ejecutar(Paso &paso, Estadisticas &estadisticas) {
+    const Comando &comando = paso.comando;
+    if (comando.tipo == ESTADISTICAS) {
+        estadisticas.contar(comando.tipo);
+        estadisticas.escribir(listado, almacen.consultar_trabajo());
+    } else if (comando.tipo == PUNTO_CONTROL) {
+        estadisticas.contar(comando.tipo);
+        paso.resultado.valor = 0; // No hay diario
+    } else if (medir) {
+        chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+        ::ejecutar(almacen, comando, paso.resultado, listado);
+        chrono::nanoseconds ns = chrono::steady_clock::now() - inicio;
+        estadisticas.registrar(comando.tipo, ns.count());
+    } else {
+        ::ejecutar(almacen, comando, paso.resultado, listado);
+        estadisticas.contar(comando.tipo);
+    }
+    // La mayoría de instrucciones no escriben nada: sólo se copia (y se
+    // vacía el stream) si hay listado.
+    if (listado.tellp() > 0) {
+        paso.listado = listado.str();
+        listado.str(string());
+    } else {
+        paso.listado.clear();
+    }
+}
+
+/*---------------+
+ | Constructores |
+ +---------------*/
+
+Tuberia::Tuberia(Almacen &almacen, Lector &lector, ostream &os,
+                 int capacidad, int ventana, bool medir)
+    : almacen(almacen), lector(lector), os(os), ventana(ventana),
+      medir(medir) {
+    assert(capacidad >= 1);
+    int potencia = 1;
+    while (potencia < capacidad) potencia *= 2;
+    pasos.resize(potencia);
+    mascara = potencia - 1;
+}
+
+/*------------------+
+ | Métodos públicos |
+ +------------------*/
+
+long long Tuberia::ejecutar(Estadisticas &estadisticas) {
+    leidos.valor = ejecutados.valor = escritos.valor = 0;
+    thread lector_hilo(&Tuberia::leer, this);
+    thread escritor_hilo(&Tuberia::escribir, this);
+    long long i = 0;
+    while (true) {
+        esperar(leidos, i);
+        Paso &paso = pasos[i & mascara];
+        // Una vez avanzado el contador, el lector puede reutilizar el paso:
+        // fin se lee antes
+        bool fin = paso.fin;
+        if (not fin) ejecutar(paso, estadisticas);
+        avanzar(ejecutados, i + 1);
+        if (fin) break;
+        ++i;
+    }
+    lector_hilo.join();
+    escritor_hilo.join();
+    return i;
+}
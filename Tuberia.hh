@@ -0,0 +1,195 @@
+/** @file
+ * Archivo que define Tuberia.
+ */
+
+#ifndef TUBERIA_HH
+#define TUBERIA_HH
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#include "Estadisticas.hh"
+#include "Lector.hh"
+#ifndef NO_DIAGRAM
+#    include <atomic>
+#    include <condition_variable>
+#    include <mutex>
+#    include <ostream>
+#    include <sstream>
+#    include <string>
+#    include <vector>
+#endif // NO_DIAGRAM
+
+using namespace std;
+
+/** Procesado de las instrucciones en tres hilos: lectura, ejecución y
+ * escritura.
+ *
+ * Los tres pasos de cada instrucción (ver Comando.hh) se hacen en hilos
+ * distintos, de forma que leer y escribir unas instrucciones se solapa con
+ * ejecutar otras:
+ * - el hilo lector lee las instrucciones (leer_comando());
+ * - el hilo que llama a ejecutar(), el único que accede al almacén, las
+ *   ejecuta y guarda el listado que escriben (p.ej. @c escribir), ya que
+ *   depende del estado del almacén en ese momento;
+ * - el hilo escritor escribe el eco, el listado y el resultado de cada una.
+ *
+ * Las instrucciones pasan de un hilo a otro por un buffer circular de
+ * @ref Paso (que se reutilizan, sin copiar las instrucciones) con un contador
+ * atómico por hilo: cada hilo sólo escribe su contador y espera a que el
+ * hilo anterior haya avanzado, primero cediendo el núcleo unas cuantas
+ * veces y después bloqueado (para no gastar CPU si la entrada se detiene).
+ * Como el
+ * buffer está acotado, el lector no se adelanta más de su capacidad al
+ * escritor. La salida es exactamente la del procesado secuencial.
+ *
+ * Las instrucciones @ref ESTADISTICAS y @ref PUNTO_CONTROL se ejecutan como
+ * en main(), sin diario (el diario se vacía al escribir en la salida, así
+ * que no se puede usar con la salida en otro hilo).
+ */
+class Tuberia {
+private:
+    /// Instrucción en el buffer, con su resultado.
+    struct Paso {
+        /// Instrucción.
+        Comando comando;
+        /// Resultado de la instrucción.
+        Resultado resultado;
+        /// Listado escrito por la instrucción.
+        string listado;
+        /// Indica que no quedan instrucciones (no hay @ref comando).
+        bool fin;
+    };
+
+    /** Contador de los pasos hechos por un hilo.
+     *
+     * Cada uno ocupa su propia línea de caché, para que avanzar un contador
+     * no invalide la copia de los otros en los demás hilos.
+     */
+    struct alignas(64) Contador {
+        /// Número de pasos hechos.
+        atomic<long long> valor;
+        /** Número de hilos bloqueados esperando al contador: sólo se avisa
+         * (con @ref cambio) si hay alguno.
+         */
+        atomic<int> bloqueados;
+        /// Protege la espera bloqueada.
+        mutex m;
+        /// Avisa de que @ref valor ha avanzado.
+        condition_variable cambio;
+
+        /// Crea un contador a 0.
+        Contador() : valor(0), bloqueados(0) {}
+    };
+
+    /// Almacén sobre el que se ejecutan las instrucciones.
+    Almacen &almacen;
+    /// Lector de la entrada.
+    Lector &lector;
+    /// Stream de salida.
+    ostream &os;
+    /// Vaciar la salida cada tantas instrucciones (0: sólo al final).
+    int ventana;
+    /// Si se mide la latencia de cada instrucción.
+    bool medir;
+
+    /** Buffer circular: el paso @em i está en la posición
+     * @em i & @ref mascara.
+     */
+    vector<Paso> pasos;
+    /// Capacidad de @ref pasos menos 1 (es una potencia de 2).
+    long long mascara;
+
+    /// Pasos leídos (escrito por el hilo lector).
+    Contador leidos;
+    /// Pasos ejecutados (escrito por el hilo que ejecuta).
+    Contador ejecutados;
+    /// Pasos escritos (escrito por el hilo escritor).
+    Contador escritos;
+
+    /// Stream en el que se escriben los listados, reutilizado.
+    ostringstream listado;
+
+    /** Espera a que un contador supere un valor.
+     *
+     * @param contador
+     * Contador de otro hilo.
+     *
+     * @param valor
+     * Valor a superar.
+     */
+    static void esperar(Contador &contador, long long valor);
+
+    /** Avanza un contador y despierta a quien lo esté esperando.
+     *
+     * @param contador
+     * Contador del hilo que llama.
+     *
+     * @param valor
+     * Nuevo valor (los pasos anteriores están hechos).
+     */
+    static void avanzar(Contador &contador, long long valor);
+
+    /// Bucle del hilo lector.
+    void leer();
+
+    /// Bucle del hilo escritor.
+    void escribir();
+
+    /** Ejecuta una instrucción y guarda su resultado y su listado.
+     *
+     * @param paso
+     * Paso leído (sin @ref Paso::fin).
+     *
+     * @param estadisticas
+     * Estadísticas en las que se cuenta la instrucción.
+     */
+    void ejecutar(Paso &paso, Estadisticas &estadisticas);
+
+public:
+    /** Crea una tubería.
+     *
+     * @param almacen
+     * Almacén sobre el que se ejecutarán las instrucciones.
+     *
+     * @param lector
+     * Lector de las instrucciones.
+     *
+     * @param os
+     * Stream en el que se escribirán las respuestas.
+     *
+     * @param capacidad
+     * Número de instrucciones en vuelo (se redondea a una potencia de 2).
+     *
+     * @param ventana
+     * Vaciar @c os cada @c ventana instrucciones (0: no vaciarlo).
+     *
+     * @param medir
+     * Si se mide la latencia de cada instrucción (ver Estadisticas).
+     *
+     * @pre
+     * @c capacidad >= 1.
+     */
+    Tuberia(Almacen &almacen, Lector &lector, ostream &os, int capacidad,
+            int ventana, bool medir);
+
+    /** Procesa todas las instrucciones hasta @c fin o el final de la
+     * entrada (sin escribir @c fin).
+     *
+     * @param estadisticas
+     * Estadísticas en las que se cuentan las instrucciones.
+     *
+     * @returns
+     * El número de instrucciones procesadas.
+     *
+     * @post
+     * Se han escrito todas las respuestas en @ref os y los hilos lector y
+     * escritor han terminado.
+     *
+     * @cost
+     * El de las instrucciones; la lectura y la escritura se solapan con la
+     * ejecución
+     */
+    long long ejecutar(Estadisticas &estadisticas);
+};
+
+#endif // TUBERIA_HH
@@ -16,7 +16,4 @@ using namespace std;
 /// Identificador de un producto.
 typedef string IdProducto;
 
-/// Inventario, representado como un map [Producto &rarr; cantidad]
-typedef map<IdProducto, int> Inventario;
-
 #endif // AUX_HH
\ No newline at end of file
@@ -0,0 +1,265 @@
+/** @file
+ * Benchmark de las operaciones de Almacen.
+ *
+ * Recorre combinaciones de forma del árbol, dimensiones de las salas,
+ * ocupación inicial y número de productos; para cada una construye un
+ * almacén y mide cada operación pública. Escribe una línea CSV por
+ * combinación y operación, con la mediana (en nanosegundos por operación)
+ * de varias repeticiones.
+ *
+ * Uso: <tt>bench/almacen.exe [--rapido] [--repeticiones=N] [--semilla=N]</tt>
+ */
+
+#include "Almacen.hh"
+#include "Lector.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// Streambuf que descarta todo lo que se escribe.
+class Descarte : public streambuf {
+protected:
+    int_type overflow(int_type c) override {
+        return traits_type::not_eof(c);
+    }
+    streamsize xsputn(const char *, streamsize n) override {
+        return n;
+    }
+};
+
+/// Parámetros de una combinación.
+struct Configuracion {
+    const char *forma;
+    int num_salas;
+    int filas, columnas;
+    double ocupacion;
+    int num_productos;
+};
+
+/// Nanosegundos transcurridos desde @c inicio.
+static double ns_desde(chrono::steady_clock::time_point inicio) {
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+/// Mediana de un vector de tiempos (lo reordena).
+static double mediana(vector<double> &t) {
+    sort(t.begin(), t.end());
+    return t[t.size() / 2];
+}
+
+/// Añade a @c s el subárbol equilibrado con las salas [primera, primera+n).
+static void arbol_equilibrado(string &s, int primera, int n) {
+    if (n == 0) {
+        s += "0 ";
+        return;
+    }
+    s += to_string(primera) + ' ';
+    int izquierdo = (n - 1) / 2;
+    arbol_equilibrado(s, primera + 1, izquierdo);
+    arbol_equilibrado(s, primera + 1 + izquierdo, n - 1 - izquierdo);
+}
+
+/// Entrada de Almacen::leer para la configuración @c conf.
+static string estructura(const Configuracion &conf) {
+    string s = to_string(conf.num_salas) + '\n';
+    if (strcmp(conf.forma, "cadena") == 0) {
+        // Cada sala es el hijo izquierdo de la anterior
+        for (int i = 1; i <= conf.num_salas; ++i) s += to_string(i) + ' ';
+        for (int i = 0; i <= conf.num_salas; ++i) s += "0 ";
+    } else {
+        arbol_equilibrado(s, 1, conf.num_salas);
+    }
+    s += '\n';
+    for (int i = 0; i < conf.num_salas; ++i) {
+        s += to_string(conf.filas) + ' ' + to_string(conf.columnas) + '\n';
+    }
+    return s;
+}
+
+/// Identificador del producto @c i.
+static IdProducto producto(int i) {
+    return "P" + to_string(i);
+}
+
+/** Construye el almacén de la configuración @c conf: llena todas las salas
+ * y luego quita ítems al azar hasta la ocupación pedida, de forma que las
+ * estanterías quedan fragmentadas.
+ */
+static void construir(Almacen &almacen, const Configuracion &conf,
+                      mt19937 &rng) {
+    string entrada = estructura(conf);
+    FILE *f = tmpfile();
+    fwrite(entrada.data(), 1, entrada.size(), f);
+    rewind(f);
+    Lector lector(fileno(f));
+    almacen.leer(lector);
+    fclose(f);
+
+    for (int p = 0; p < conf.num_productos; ++p) almacen.poner_prod(producto(p));
+    int tamano = conf.filas * conf.columnas;
+    int objetivo = int(conf.ocupacion * tamano);
+    for (int s = 1; s <= conf.num_salas; ++s) {
+        while (almacen.poner_items(s, producto(rng() % conf.num_productos),
+                                   1 + rng() % 16) == 0) {}
+        int ocupados = tamano;
+        while (ocupados > objetivo) {
+            int cantidad = min<int>(1 + rng() % 16, ocupados - objetivo);
+            ocupados -= cantidad - almacen.quitar_items(
+                                       s, producto(rng() % conf.num_productos),
+                                       cantidad);
+        }
+    }
+}
+
+/// Escribe una línea de resultados.
+static void escribir(const Configuracion &conf, const char *operacion,
+                     int operaciones, vector<double> &tiempos) {
+    cout << operacion << ',' << conf.forma << ',' << conf.num_salas << ','
+         << conf.filas << ',' << conf.columnas << ',' << conf.ocupacion << ','
+         << conf.num_productos << ',' << operaciones << ','
+         << mediana(tiempos) / operaciones << endl;
+}
+
+/// Mide todas las operaciones sobre la configuración @c conf.
+static void medir(const Configuracion &conf, int reps, mt19937 &rng) {
+    Almacen base;
+    construir(base, conf, rng);
+    Descarte descarte;
+    ostream nulo(&descarte);
+
+    const int OPS = 10000;
+    vector<int> salas(OPS);
+    vector<IdProducto> productos(OPS);
+    for (int i = 0; i < OPS; ++i) {
+        salas[i] = 1 + rng() % conf.num_salas;
+        productos[i] = producto(rng() % conf.num_productos);
+    }
+
+    vector<OperacionLote> lote(2 * OPS);
+    for (int i = 0; i < OPS; ++i) {
+        lote[i] = {salas[i], productos[i], 1, true};
+        lote[2 * OPS - 1 - i] = {salas[i], productos[i], 1, false};
+    }
+
+    vector<double> t_poner, t_quitar, t_lote, t_distribuir, t_compactar,
+        t_reorganizar, t_redimensionar, t_escribir, t_inventario;
+    for (int r = 0; r < reps; ++r) {
+        // poner_items y quitar_items se deshacen mutuamente: el almacén
+        // vuelve al estado inicial.
+        Almacen almacen = base;
+        chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+        for (int i = 0; i < OPS; ++i) {
+            almacen.poner_items(salas[i], productos[i], 1);
+        }
+        t_poner.push_back(ns_desde(inicio));
+
+        inicio = chrono::steady_clock::now();
+        for (int i = OPS - 1; i >= 0; --i) {
+            almacen.quitar_items(salas[i], productos[i], 1);
+        }
+        t_quitar.push_back(ns_desde(inicio));
+
+        // Las mismas operaciones, en un solo lote
+        inicio = chrono::steady_clock::now();
+        almacen.aplicar_lote(lote);
+        t_lote.push_back(ns_desde(inicio));
+
+        inicio = chrono::steady_clock::now();
+        for (int s = 1; s <= conf.num_salas; ++s) almacen.escribir(s, nulo);
+        t_escribir.push_back(ns_desde(inicio));
+
+        inicio = chrono::steady_clock::now();
+        almacen.inventario(nulo);
+        t_inventario.push_back(ns_desde(inicio));
+
+        // El resto de operaciones modifican el almacén: cada una empieza
+        // con una copia nueva.
+        almacen = base;
+        inicio = chrono::steady_clock::now();
+        for (int i = 0; i < OPS; ++i) almacen.distribuir(productos[i], 16);
+        t_distribuir.push_back(ns_desde(inicio));
+
+        almacen = base;
+        inicio = chrono::steady_clock::now();
+        for (int s = 1; s <= conf.num_salas; ++s) almacen.compactar(s);
+        t_compactar.push_back(ns_desde(inicio));
+
+        almacen = base;
+        inicio = chrono::steady_clock::now();
+        for (int s = 1; s <= conf.num_salas; ++s) almacen.reorganizar(s);
+        t_reorganizar.push_back(ns_desde(inicio));
+
+        almacen = base;
+        inicio = chrono::steady_clock::now();
+        for (int s = 1; s <= conf.num_salas; ++s) {
+            almacen.redimensionar(s, conf.columnas, conf.filas);
+        }
+        t_redimensionar.push_back(ns_desde(inicio));
+    }
+
+    escribir(conf, "poner_items", OPS, t_poner);
+    escribir(conf, "quitar_items", OPS, t_quitar);
+    escribir(conf, "lote", 2 * OPS, t_lote);
+    escribir(conf, "distribuir", OPS, t_distribuir);
+    escribir(conf, "compactar", conf.num_salas, t_compactar);
+    escribir(conf, "reorganizar", conf.num_salas, t_reorganizar);
+    escribir(conf, "redimensionar", conf.num_salas, t_redimensionar);
+    escribir(conf, "escribir", conf.num_salas, t_escribir);
+    escribir(conf, "inventario", 1, t_inventario);
+}
+
+int main(int argc, char *argv[]) {
+    bool rapido = false;
+    int reps = 5;
+    unsigned semilla = 42;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--rapido") == 0) {
+            rapido = true;
+        } else if (strncmp(argv[i], "--repeticiones=", 15) == 0) {
+            reps = atoi(argv[i] + 15);
+        } else if (strncmp(argv[i], "--semilla=", 10) == 0) {
+            semilla = strtoul(argv[i] + 10, NULL, 10);
+        } else {
+            cerr << "Opción desconocida: " << argv[i] << endl;
+            return 1;
+        }
+    }
+    if (reps < 1) reps = 1;
+
+    vector<const char *> formas = {"equilibrado", "cadena"};
+    vector<int> lados = {8, 32, 128};
+    vector<double> ocupaciones = {0.25, 0.5, 0.9};
+    vector<int> num_productos = {16, 1024};
+    const int NUM_SALAS = 127;
+    if (rapido) {
+        lados = {32};
+        ocupaciones = {0.5};
+        num_productos = {64};
+    }
+
+    cout << "operacion,forma,salas,filas,columnas,ocupacion,productos,"
+            "operaciones,ns_por_operacion"
+         << endl;
+    mt19937 rng(semilla);
+    for (const char *forma : formas) {
+        for (int lado : lados) {
+            for (double ocupacion : ocupaciones) {
+                for (int n : num_productos) {
+                    Configuracion conf = {forma,     NUM_SALAS, lado,
+                                          lado / 2,  ocupacion, n};
+                    medir(conf, reps, rng);
+                }
+            }
+        }
+    }
+}
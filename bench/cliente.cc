@@ -0,0 +1,218 @@
+/** @file
+ * Cliente de carga para el modo servidor (ver Servidor).
+ *
+ * Lee una entrada (p.ej. generada con bench/generar.exe), salta la
+ * estructura del almacén (que el servidor ya ha leído) y reparte sus
+ * instrucciones por turnos entre varios clientes, cada uno en un hilo con
+ * su propia conexión. Cada cliente mantiene hasta @c ventana instrucciones
+ * enviadas sin respuesta, y una instrucción se da por respondida al recibir
+ * su eco (el servidor envía cada respuesta entera). El servidor tiene que
+ * empezar con el almacén de la misma entrada; como las instrucciones de
+ * clientes distintos se intercalan, alguna puede dejar de ser válida (p.ej.
+ * un @c consultar_pos tras un @c redimensionar de otro cliente) y recibir
+ * un error.
+ *
+ * Escribe en CSV las instrucciones por segundo del conjunto y los
+ * percentiles de latencia (desde que se envía cada instrucción hasta que se
+ * recibe su eco).
+ *
+ * Con <tt>--respuestas</tt>, un solo cliente envía todas las instrucciones y
+ * escribe las respuestas por la salida estándar, que deberían coincidir con
+ * las de <tt>program.exe < entrada.inp</tt>.
+ *
+ * Uso: <tt>bench/cliente.exe socket entrada.inp [clientes] [ventana]</tt>
+ * (por defecto, 8 clientes con una ventana de 16 instrucciones), o
+ * <tt>bench/cliente.exe socket entrada.inp --respuestas</tt>.
+ */
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#include "Lector.hh"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Reloj;
+
+/// Trabajo y resultados de un cliente.
+struct Cliente {
+    /// Instrucciones que envía, cada una en su línea.
+    vector<string> comandos;
+    /// Latencias en nanosegundos de cada instrucción.
+    vector<long long> latencias;
+    /// Si no es nulo, stream en el que se escriben las respuestas.
+    ostream *respuestas;
+    /// Indica que se ha perdido la conexión antes de tiempo.
+    bool error;
+};
+
+/// Abre una conexión con el socket Unix @c ruta (o devuelve -1).
+static int conectar(const char *ruta) {
+    sockaddr_un direccion;
+    memset(&direccion, 0, sizeof direccion);
+    direccion.sun_family = AF_UNIX;
+    strncpy(direccion.sun_path, ruta, sizeof direccion.sun_path - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&direccion),
+                sizeof direccion) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/** Bucle de un cliente: envía sus instrucciones (y @c fin) respetando la
+ * ventana y lee las respuestas hasta que el servidor cierra la conexión.
+ */
+static void atender(const char *ruta, int ventana, Cliente &cliente) {
+    cliente.error = true;
+    int fd = conectar(ruta);
+    if (fd < 0) return;
+    int total = cliente.comandos.size();
+    vector<Reloj::time_point> enviada(total);
+    cliente.latencias.reserve(total);
+    string pendiente;   // Datos por enviar
+    int enviadas = 0;   // Instrucciones añadidas a pendiente
+    int respondidas = 0;
+    bool fin_enviado = false;
+    bool inicio_linea = true;
+    char bloque[1 << 16];
+    while (true) {
+        // Llenar la ventana
+        while (enviadas < total and enviadas - respondidas < ventana) {
+            pendiente += cliente.comandos[enviadas];
+            enviada[enviadas++] = Reloj::now();
+        }
+        if (enviadas == total and not fin_enviado) {
+            pendiente += "fin\n";
+            fin_enviado = true;
+        }
+
+        pollfd p;
+        p.fd = fd;
+        p.events = POLLIN | (pendiente.empty() ? 0 : POLLOUT);
+        if (poll(&p, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (p.revents & POLLOUT) {
+            ssize_t n = send(fd, pendiente.data(), pendiente.size(),
+                             MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0 and errno != EAGAIN and errno != EINTR) break;
+            if (n > 0) pendiente.erase(0, n);
+        }
+        if (p.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = recv(fd, bloque, sizeof bloque, MSG_DONTWAIT);
+            if (n < 0 and (errno == EAGAIN or errno == EINTR)) continue;
+            if (n <= 0) {
+                // El servidor cierra tras responder a fin
+                cliente.error = respondidas < total;
+                break;
+            }
+            if (cliente.respuestas) cliente.respuestas->write(bloque, n);
+            Reloj::time_point ahora = Reloj::now();
+            for (int i = 0; i < n; ++i) {
+                // El eco es la única línea que no empieza con un espacio
+                if (inicio_linea and bloque[i] != ' ' and
+                    respondidas < enviadas) {
+                    chrono::nanoseconds ns = ahora - enviada[respondidas++];
+                    cliente.latencias.push_back(ns.count());
+                }
+                inicio_linea = bloque[i] == '\n';
+            }
+        }
+    }
+    close(fd);
+}
+
+/// Percentil @c p (entre 0 y 1) de @c v, ordenado.
+static long long percentil(const vector<long long> &v, double p) {
+    if (v.empty()) return 0;
+    return v[min<size_t>(v.size() - 1, p * v.size())];
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        cerr << "Uso: " << argv[0]
+             << " socket entrada.inp [clientes] [ventana]\n"
+             << "     " << argv[0] << " socket entrada.inp --respuestas"
+             << endl;
+        return 1;
+    }
+    bool volcar = argc > 3 and strcmp(argv[3], "--respuestas") == 0;
+    int num_clientes = volcar ? 1 : argc > 3 ? max(1, atoi(argv[3])) : 8;
+    int ventana = volcar ? 1 << 30 : argc > 4 ? max(1, atoi(argv[4])) : 16;
+
+    // Leer la entrada y saltar la estructura del almacén
+    ifstream fichero(argv[2], ios::binary);
+    if (not fichero) {
+        cerr << "No se ha podido abrir " << argv[2] << endl;
+        return 1;
+    }
+    stringstream contenido;
+    contenido << fichero.rdbuf();
+    string datos = contenido.str();
+    vector<Cliente> clientes(num_clientes);
+    long long total = 0;
+    {
+        Lector lector(datos.data(), datos.size());
+        Almacen almacen;
+        almacen.leer(lector);
+        Comando comando;
+        ostringstream linea;
+        while (leer_comando(lector, comando) and comando.tipo != FIN) {
+            escribir_eco(linea, comando);
+            linea << '\n';
+            clientes[total++ % num_clientes].comandos.push_back(linea.str());
+            linea.str(string());
+        }
+    }
+    for (Cliente &cliente : clientes) {
+        cliente.respuestas = volcar ? &cout : NULL;
+    }
+
+    Reloj::time_point inicio = Reloj::now();
+    vector<thread> hilos;
+    for (Cliente &cliente : clientes) {
+        hilos.push_back(thread(atender, argv[1], ventana, ref(cliente)));
+    }
+    for (thread &t : hilos) t.join();
+    chrono::duration<double, milli> ms = Reloj::now() - inicio;
+
+    vector<long long> todas;
+    bool error = false;
+    for (const Cliente &cliente : clientes) {
+        todas.insert(todas.end(), cliente.latencias.begin(),
+                     cliente.latencias.end());
+        error = error or cliente.error;
+    }
+    if (error) {
+        cerr << "Se ha perdido alguna conexión con " << argv[1] << endl;
+        return 1;
+    }
+    if (volcar) return 0;
+    sort(todas.begin(), todas.end());
+    cout << "clientes,ventana,instrucciones,ms,instrucciones_por_s,p50_ns,"
+            "p99_ns,p999_ns,max_ns"
+         << endl;
+    cout << num_clientes << ',' << ventana << ',' << total << ','
+         << ms.count() << ',' << 1000 * total / ms.count() << ','
+         << percentil(todas, 0.5) << ',' << percentil(todas, 0.99) << ','
+         << percentil(todas, 0.999) << ','
+         << (todas.empty() ? 0 : todas.back()) << endl;
+}
@@ -0,0 +1,145 @@
+/** @file
+ * Benchmark de Diario.
+ *
+ * Mide el coste de anotar las instrucciones en el diario (según el tamaño
+ * del lote que se escribe y sincroniza de golpe) y el tiempo de recuperar el
+ * almacén según la longitud del diario. Escribe los resultados en CSV.
+ *
+ * Uso: <tt>bench/diario.exe [instrucciones]</tt>
+ */
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#include "Diario.hh"
+#include "Lector.hh"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/// Número de salas del almacén (en cadena, 32x32 cada una).
+static const int NUM_SALAS = 64;
+/// Número de productos.
+static const int NUM_PRODUCTOS = 256;
+
+/// Milisegundos transcurridos desde @c inicio.
+static double ms_desde(chrono::steady_clock::time_point inicio) {
+    chrono::duration<double, milli> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+/// Crea el almacén de las pruebas.
+static void crear(Almacen &almacen) {
+    string entrada = to_string(NUM_SALAS) + '\n';
+    for (int i = 1; i <= NUM_SALAS; ++i) entrada += to_string(i) + ' ';
+    for (int i = 0; i <= NUM_SALAS; ++i) entrada += "0 ";
+    for (int i = 0; i < NUM_SALAS; ++i) entrada += "\n32 32";
+    entrada += '\n';
+    FILE *f = tmpfile();
+    fwrite(entrada.data(), 1, entrada.size(), f);
+    rewind(f);
+    Lector lector(fileno(f));
+    almacen.leer(lector);
+    fclose(f);
+}
+
+/// Instrucciones de las pruebas: altas de productos y operaciones de sala.
+static vector<Comando> instrucciones(int n) {
+    mt19937 rng(42);
+    vector<Comando> v;
+    Comando c;
+    c.tipo = PONER_PROD;
+    for (int p = 0; p < NUM_PRODUCTOS; ++p) {
+        c.id_producto = "P" + to_string(p);
+        v.push_back(c);
+    }
+    while (v.size() < n) {
+        int r = rng() % 10;
+        c.tipo = r < 4 ? PONER_ITEMS : r < 8 ? QUITAR_ITEMS : DISTRIBUIR;
+        c.id_sala = 1 + rng() % NUM_SALAS;
+        c.id_producto = "P" + to_string(rng() % NUM_PRODUCTOS);
+        c.cantidad = 1 + rng() % 16;
+        v.push_back(c);
+    }
+    return v;
+}
+
+/** Ejecuta las instrucciones, anotándolas en un diario con prefijo
+ * @c prefijo (si no está vacío) y lotes de @c lote instrucciones.
+ *
+ * @returns
+ * Tiempo en milisegundos.
+ */
+static double ejecutar_todas(const vector<Comando> &v, const string &prefijo,
+                             int lote) {
+    Almacen almacen;
+    crear(almacen);
+    Resultado resultado;
+    ostream nulo(NULL);
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    if (prefijo.empty()) {
+        for (int i = 0; i < v.size(); ++i) {
+            ejecutar(almacen, v[i], resultado, nulo);
+        }
+    } else {
+        Diario diario(prefijo, lote);
+        diario.recuperar(almacen);
+        for (int i = 0; i < v.size(); ++i) {
+            diario.anotar(v[i]);
+            ejecutar(almacen, v[i], resultado, nulo);
+        }
+        diario.confirmar();
+    }
+    return ms_desde(inicio);
+}
+
+/// Borra los ficheros del diario con prefijo @c prefijo.
+static void borrar(const string &prefijo) {
+    unlink((prefijo + ".0.diario").c_str());
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 20000;
+    char plantilla[] = "/tmp/diarioXXXXXX";
+    if (mkdtemp(plantilla) == NULL) {
+        cerr << "No se ha podido crear el directorio temporal" << endl;
+        return 1;
+    }
+    string prefijo = string(plantilla) + "/bench";
+
+    cout << "prueba,lote,instrucciones,ms,us_por_instruccion" << endl;
+
+    // Escritura: coste de anotar según el tamaño del lote
+    vector<Comando> v = instrucciones(n);
+    double t = ejecutar_todas(v, "", 1);
+    cout << "sin_diario,0," << v.size() << ',' << t << ','
+         << 1000 * t / v.size() << endl;
+    int lotes[] = {1, 8, 64, 512, 4096};
+    for (int lote : lotes) {
+        t = ejecutar_todas(v, prefijo, lote);
+        borrar(prefijo);
+        cout << "escritura," << lote << ',' << v.size() << ',' << t << ','
+             << 1000 * t / v.size() << endl;
+    }
+
+    // Recuperación: tiempo según la longitud del diario
+    for (int longitud = 1000; longitud <= 100 * n; longitud *= 10) {
+        ejecutar_todas(instrucciones(longitud), prefijo, 4096);
+        Almacen almacen;
+        crear(almacen);
+        chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+        Diario diario(prefijo, 4096);
+        long long recuperadas = diario.recuperar(almacen);
+        t = ms_desde(inicio);
+        borrar(prefijo);
+        cout << "recuperacion,0," << recuperadas << ',' << t << ','
+             << 1000 * t / recuperadas << endl;
+    }
+    rmdir(plantilla);
+}
@@ -0,0 +1,317 @@
+/** @file
+ * Generador de entradas de gran tamaño (en el formato de @c sample.inp).
+ *
+ * Genera un almacén (estructura y dimensiones de las salas) y una secuencia
+ * de instrucciones. Los productos de cada instrucción siguen una
+ * distribución de Zipf, como el tráfico real, en el que unos pocos
+ * productos concentran la mayoría de operaciones. Con la misma semilla y
+ * las mismas opciones, la salida es siempre la misma.
+ *
+ * Uso: <tt>bench/generar.exe [opciones] > entrada.inp</tt>
+ *
+ * Opciones (entre paréntesis, el valor por defecto):
+ * - <tt>--salas=N</tt> (1000): número de salas.
+ * - <tt>--forma=equilibrado|cadena|aleatorio</tt> (aleatorio): forma del
+ *   árbol de salas.
+ * - <tt>--filas=A-B</tt>, <tt>--columnas=A-B</tt> (1-50): rango de las
+ *   dimensiones de las salas.
+ * - <tt>--dimensiones=uniforme|sesgada</tt> (uniforme): distribución de las
+ *   dimensiones en su rango; @c sesgada es log-uniforme (muchas salas
+ *   pequeñas y pocas grandes).
+ * - <tt>--productos=N</tt> (1000): número de productos distintos.
+ * - <tt>--zipf=S</tt> (1.0): exponente de la distribución de Zipf de los
+ *   productos (0 es uniforme).
+ * - <tt>--comandos=N</tt> (1000000): número de instrucciones.
+ * - <tt>--mezcla=op:peso,...</tt>: peso relativo de cada instrucción (las
+ *   que no aparecen mantienen el peso por defecto).
+ * - <tt>--semilla=N</tt> (1): semilla del generador aleatorio.
+ *
+ * Se generan sólo instrucciones que cumplen las precondiciones del programa:
+ * en @c consultar_pos la posición existe aunque algún @c redimensionar
+ * anterior haya fallado.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// Instrucciones que se generan, con su peso por defecto.
+static struct {
+    const char *nombre;
+    double peso;
+} MEZCLA[] = {
+    {"poner_items", 30},   {"quitar_items", 25},  {"distribuir", 15},
+    {"consultar_prod", 10}, {"consultar_pos", 10}, {"compactar", 3},
+    {"reorganizar", 3},    {"redimensionar", 1},  {"poner_prod", 1},
+    {"quitar_prod", 1},    {"escribir", 0.5},     {"inventario", 0.1},
+};
+static const int NUM_INSTRUCCIONES = sizeof(MEZCLA) / sizeof(MEZCLA[0]);
+
+/// Salida con buffer propio (mucho más rápida que @c printf).
+class Escritor {
+private:
+    string buffer;
+
+public:
+    ~Escritor() {
+        vaciar();
+    }
+    void vaciar() {
+        fwrite(buffer.data(), 1, buffer.size(), stdout);
+        buffer.clear();
+    }
+    Escritor &operator<<(const string &s) {
+        buffer += s;
+        return *this;
+    }
+    Escritor &operator<<(const char *s) {
+        buffer += s;
+        return *this;
+    }
+    Escritor &operator<<(char c) {
+        buffer += c;
+        if (c == '\n' and buffer.size() >= (1 << 20)) vaciar();
+        return *this;
+    }
+    Escritor &operator<<(int n) {
+        char tmp[12];
+        int l = 0;
+        unsigned u = n < 0 ? -unsigned(n) : n;
+        do {
+            tmp[l++] = '0' + u % 10;
+            u /= 10;
+        } while (u > 0);
+        if (n < 0) buffer += '-';
+        while (l > 0) buffer += tmp[--l];
+        return *this;
+    }
+};
+
+/// Productos con distribución de Zipf sobre [0, n).
+class Zipf {
+private:
+    /// Función de distribución acumulada.
+    vector<double> acumulada;
+
+public:
+    Zipf(int n, double s) : acumulada(n) {
+        double total = 0;
+        for (int i = 0; i < n; ++i) {
+            total += 1 / pow(i + 1, s);
+            acumulada[i] = total;
+        }
+        for (int i = 0; i < n; ++i) acumulada[i] /= total;
+    }
+    int operator()(mt19937_64 &rng) const {
+        double u = uniform_real_distribution<double>(0, 1)(rng);
+        int i = lower_bound(acumulada.begin(), acumulada.end(), u) -
+                acumulada.begin();
+        return min<int>(i, acumulada.size() - 1);
+    }
+};
+
+/// Rango de valores enteros, con distribución uniforme o log-uniforme.
+struct Rango {
+    int minimo, maximo;
+    bool sesgado;
+    int operator()(mt19937_64 &rng) const {
+        if (not sesgado) {
+            return uniform_int_distribution<int>(minimo, maximo)(rng);
+        }
+        double l = uniform_real_distribution<double>(log(minimo),
+                                                     log(maximo + 1.0))(rng);
+        return min<int>(maximo, exp(l));
+    }
+};
+
+/// Lee un rango @c A-B (o un sólo valor @c A).
+static bool leer_rango(const char *s, Rango &rango) {
+    char *fin;
+    rango.minimo = strtol(s, &fin, 10);
+    rango.maximo = rango.minimo;
+    if (*fin == '-') rango.maximo = strtol(fin + 1, &fin, 10);
+    return *fin == '\0' and 0 < rango.minimo and
+           rango.minimo <= rango.maximo;
+}
+
+/// Lee una lista @c op:peso,... y modifica los pesos de @ref MEZCLA.
+static bool leer_mezcla(const char *s) {
+    string lista = s;
+    size_t inicio = 0;
+    while (inicio < lista.size()) {
+        size_t fin = lista.find(',', inicio);
+        if (fin == string::npos) fin = lista.size();
+        string elemento = lista.substr(inicio, fin - inicio);
+        size_t dos_puntos = elemento.find(':');
+        if (dos_puntos == string::npos) return false;
+        string nombre = elemento.substr(0, dos_puntos);
+        int i = 0;
+        while (i < NUM_INSTRUCCIONES and nombre != MEZCLA[i].nombre) ++i;
+        if (i == NUM_INSTRUCCIONES) return false;
+        MEZCLA[i].peso = atof(elemento.c_str() + dos_puntos + 1);
+        if (MEZCLA[i].peso < 0) return false;
+        inicio = fin + 1;
+    }
+    return true;
+}
+
+/// Identificador del producto @c i (letras mayúsculas en base 26).
+static string producto(int i) {
+    string id;
+    do {
+        id += char('A' + i % 26);
+        i /= 26;
+    } while (i > 0);
+    if (id.size() < 2) id += 'A';
+    return id;
+}
+
+/** Escribe un árbol de @c n salas en preorden, numeradas de 1 a @c n en el
+ * orden en que aparecen (sin recursión, para que una cadena larga no
+ * desborde la pila).
+ */
+static void escribir_arbol(Escritor &out, int n, const string &forma,
+                           mt19937_64 &rng) {
+    vector<int> pendientes(1, n); // Tamaños de los subárboles por escribir
+    int siguiente = 1;
+    while (not pendientes.empty()) {
+        int tam = pendientes.back();
+        pendientes.pop_back();
+        if (tam == 0) {
+            out << 0 << ' ';
+            continue;
+        }
+        out << siguiente++ << ' ';
+        int izquierdo;
+        if (forma == "cadena") {
+            izquierdo = tam - 1;
+        } else if (forma == "equilibrado") {
+            izquierdo = (tam - 1) / 2;
+        } else {
+            izquierdo = uniform_int_distribution<int>(0, tam - 1)(rng);
+        }
+        pendientes.push_back(tam - 1 - izquierdo);
+        pendientes.push_back(izquierdo);
+    }
+    out << '\n';
+}
+
+int main(int argc, char *argv[]) {
+    int num_salas = 1000, num_productos = 1000, num_comandos = 1000000;
+    string forma = "aleatorio";
+    Rango filas = {1, 50, false}, columnas = {1, 50, false};
+    double s = 1.0;
+    unsigned long semilla = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *valor = strchr(arg, '=');
+        bool ok = valor != NULL;
+        if (ok) {
+            string opcion(arg, valor++);
+            if (opcion == "--salas") {
+                num_salas = atoi(valor);
+                ok = num_salas > 0;
+            } else if (opcion == "--forma") {
+                forma = valor;
+                ok = forma == "equilibrado" or forma == "cadena" or
+                     forma == "aleatorio";
+            } else if (opcion == "--filas") {
+                ok = leer_rango(valor, filas);
+            } else if (opcion == "--columnas") {
+                ok = leer_rango(valor, columnas);
+            } else if (opcion == "--dimensiones") {
+                ok = strcmp(valor, "uniforme") == 0 or
+                     strcmp(valor, "sesgada") == 0;
+                filas.sesgado = columnas.sesgado =
+                    strcmp(valor, "sesgada") == 0;
+            } else if (opcion == "--productos") {
+                num_productos = atoi(valor);
+                ok = num_productos > 0;
+            } else if (opcion == "--zipf") {
+                s = atof(valor);
+                ok = s >= 0;
+            } else if (opcion == "--comandos") {
+                num_comandos = atoi(valor);
+                ok = num_comandos >= 0;
+            } else if (opcion == "--mezcla") {
+                ok = leer_mezcla(valor);
+            } else if (opcion == "--semilla") {
+                semilla = strtoul(valor, NULL, 10);
+            } else {
+                ok = false;
+            }
+        }
+        if (not ok) {
+            cerr << "Opción incorrecta: " << arg << endl;
+            return 1;
+        }
+    }
+
+    mt19937_64 rng(semilla);
+    Escritor out;
+
+    // Almacén
+    out << num_salas << '\n';
+    escribir_arbol(out, num_salas, forma, rng);
+    // Dimensiones mínimas de cada sala en toda la ejecución: son válidas
+    // para consultar_pos pase lo que pase con redimensionar.
+    vector<int> min_filas(num_salas + 1), min_columnas(num_salas + 1);
+    for (int i = 1; i <= num_salas; ++i) {
+        min_filas[i] = filas(rng);
+        min_columnas[i] = columnas(rng);
+        out << min_filas[i] << ' ' << min_columnas[i] << '\n';
+    }
+
+    // Productos: el orden de popularidad no coincide con el alfabético
+    vector<string> productos(num_productos);
+    for (int i = 0; i < num_productos; ++i) productos[i] = producto(i);
+    shuffle(productos.begin(), productos.end(), rng);
+    Zipf zipf(num_productos, s);
+    for (int i = 0; i < num_productos; ++i) {
+        out << "poner_prod " << productos[i] << '\n';
+    }
+
+    // Instrucciones
+    vector<double> pesos(NUM_INSTRUCCIONES);
+    for (int i = 0; i < NUM_INSTRUCCIONES; ++i) pesos[i] = MEZCLA[i].peso;
+    discrete_distribution<int> instruccion(pesos.begin(), pesos.end());
+    uniform_int_distribution<int> sala(1, num_salas);
+    geometric_distribution<int> cantidad(0.1);
+    for (int i = 0; i < num_comandos; ++i) {
+        string nombre = MEZCLA[instruccion(rng)].nombre;
+        out << nombre;
+        if (nombre == "poner_items" or nombre == "quitar_items") {
+            out << ' ' << sala(rng) << ' ' << productos[zipf(rng)] << ' '
+                << 1 + cantidad(rng);
+        } else if (nombre == "distribuir") {
+            out << ' ' << productos[zipf(rng)] << ' ' << 1 + cantidad(rng);
+        } else if (nombre == "consultar_prod" or nombre == "poner_prod" or
+                   nombre == "quitar_prod") {
+            out << ' ' << productos[zipf(rng)];
+        } else if (nombre == "consultar_pos") {
+            int id = sala(rng);
+            out << ' ' << id << ' '
+                << uniform_int_distribution<int>(1, min_filas[id])(rng)
+                << ' '
+                << uniform_int_distribution<int>(1, min_columnas[id])(rng);
+        } else if (nombre == "redimensionar") {
+            int id = sala(rng);
+            int f = filas(rng), c = columnas(rng);
+            min_filas[id] = min(min_filas[id], f);
+            min_columnas[id] = min(min_columnas[id], c);
+            out << ' ' << id << ' ' << f << ' ' << c;
+        } else if (nombre != "inventario") {
+            out << ' ' << sala(rng); // compactar, reorganizar, escribir
+        }
+        out << '\n';
+    }
+    out << "fin" << '\n';
+}
@@ -0,0 +1,189 @@
+/** @file
+ * Benchmark de las vistas de Almacen (ver Almacen::vista).
+ *
+ * Un hilo escritor ejecuta las instrucciones de una entrada (p.ej. generada
+ * con bench/generar.exe) y publica una vista nueva cada cierto número de
+ * instrucciones. A la vez, varios hilos lectores consultan sin parar la
+ * última vista publicada (@c consultar_pos, @c consultar_prod,
+ * @c escribir e @c inventario) y miden la latencia de cada consulta.
+ *
+ * Escribe en CSV el ritmo del escritor y, para cada consulta, los
+ * percentiles de latencia de los lectores.
+ *
+ * Uso: <tt>bench/lecturas.exe entrada.inp [lectores] [cada]</tt>
+ * (por defecto, 2 lectores y una vista cada 1000 instrucciones).
+ */
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#include "Lector.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/// Consultas de los lectores.
+enum Consulta { C_POS, C_PROD, C_ESCRIBIR, C_INVENTARIO, NUM_CONSULTAS };
+
+/// Nombre de cada consulta.
+static const char *NOMBRES[NUM_CONSULTAS] = {"consultar_pos", "consultar_prod",
+                                             "escribir", "inventario"};
+
+/// Estado compartido por el escritor y los lectores.
+struct Compartido {
+    /// Última vista publicada (se lee y se escribe con atomic_load/store).
+    shared_ptr<const VistaAlmacen> vista;
+    /// Indica que el escritor ha terminado.
+    atomic<bool> terminado;
+    /// Identificadores de los productos de la entrada.
+    vector<IdProducto> productos;
+};
+
+/// Latencias en nanosegundos de cada tipo de consulta.
+struct Latencias {
+    vector<long long> consulta[NUM_CONSULTAS];
+};
+
+/// Stream que descarta todo lo que se escribe.
+class Descarte : public streambuf {
+protected:
+    int_type overflow(int_type c) override {
+        return traits_type::not_eof(c);
+    }
+    streamsize xsputn(const char *, streamsize n) override {
+        return n;
+    }
+};
+
+/** Bucle de un lector: consulta la última vista hasta que el escritor
+ * termina.
+ *
+ * @param[out] latencias
+ * Latencias de las consultas del lector.
+ */
+static void leer(Compartido &compartido, int semilla, Latencias &latencias) {
+    mt19937 rng(semilla);
+    ostringstream os;
+    // escribir e inventario son mucho más lentas: se hacen menos
+    discrete_distribution<int> consulta({45, 45, 9, 1});
+    while (not compartido.terminado.load()) {
+        shared_ptr<const VistaAlmacen> vista = atomic_load(&compartido.vista);
+        int c = consulta(rng);
+        IdSala id_sala = 1 + rng() % vista->num_salas();
+        chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+        switch (c) {
+            case C_POS: vista->consultar_pos(id_sala, 1, 1); break;
+            case C_PROD:
+                if (not compartido.productos.empty()) {
+                    vista->consultar_prod(
+                        compartido.productos[rng() %
+                                             compartido.productos.size()]);
+                }
+                break;
+            case C_ESCRIBIR: vista->escribir(id_sala, os); break;
+            case C_INVENTARIO: vista->inventario(os); break;
+        }
+        chrono::nanoseconds ns = chrono::steady_clock::now() - inicio;
+        latencias.consulta[c].push_back(ns.count());
+        os.str(string());
+    }
+}
+
+/// Percentil @c p (entre 0 y 1) de @c v, ordenado.
+static long long percentil(const vector<long long> &v, double p) {
+    if (v.empty()) return 0;
+    return v[min<size_t>(v.size() - 1, p * v.size())];
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        cerr << "Uso: " << argv[0] << " entrada.inp [lectores] [cada]"
+             << endl;
+        return 1;
+    }
+    int num_lectores = argc > 2 ? atoi(argv[2]) : 2;
+    int cada = argc > 3 ? max(1, atoi(argv[3])) : 1000;
+
+    // Leer el almacén y todas las instrucciones
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0) {
+        cerr << "No se ha podido abrir " << argv[1] << endl;
+        return 1;
+    }
+    Almacen almacen;
+    vector<Comando> comandos;
+    Compartido compartido;
+    {
+        Lector lector(fd);
+        almacen.leer(lector);
+        Comando comando;
+        while (leer_comando(lector, comando) and comando.tipo != FIN) {
+            if (comando.tipo == ESTADISTICAS or comando.tipo == PUNTO_CONTROL)
+                continue;
+            if (comando.tipo == PONER_PROD) {
+                compartido.productos.push_back(comando.id_producto);
+            }
+            comandos.push_back(comando);
+        }
+    }
+    close(fd);
+
+    compartido.terminado = false;
+    atomic_store(&compartido.vista,
+                 make_shared<const VistaAlmacen>(almacen.vista()));
+    vector<Latencias> por_lector(num_lectores);
+    vector<thread> lectores;
+    for (int i = 0; i < num_lectores; ++i) {
+        lectores.push_back(
+            thread(leer, ref(compartido), i + 1, ref(por_lector[i])));
+    }
+
+    // Escritor
+    Descarte descarte;
+    ostream nulo(&descarte);
+    Resultado resultado;
+    long long vistas = 0;
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    for (int i = 0; i < comandos.size(); ++i) {
+        ejecutar(almacen, comandos[i], resultado, nulo);
+        if ((i + 1) % cada == 0) {
+            atomic_store(&compartido.vista,
+                         make_shared<const VistaAlmacen>(almacen.vista()));
+            ++vistas;
+        }
+    }
+    chrono::duration<double, milli> ms = chrono::steady_clock::now() - inicio;
+    compartido.terminado = true;
+    for (thread &t : lectores) t.join();
+
+    cout << "escritor,lectores,instrucciones,vistas,ms,instrucciones_por_s"
+         << endl;
+    cout << "escritor," << num_lectores << ',' << comandos.size() << ','
+         << vistas << ',' << ms.count() << ','
+         << 1000 * comandos.size() / ms.count() << endl;
+    cout << "consulta,lectores,consultas,p50_ns,p99_ns,p999_ns,max_ns"
+         << endl;
+    for (int c = 0; c < NUM_CONSULTAS; ++c) {
+        vector<long long> todas;
+        for (int i = 0; i < num_lectores; ++i) {
+            const vector<long long> &v = por_lector[i].consulta[c];
+            todas.insert(todas.end(), v.begin(), v.end());
+        }
+        sort(todas.begin(), todas.end());
+        cout << NOMBRES[c] << ',' << num_lectores << ',' << todas.size()
+             << ',' << percentil(todas, 0.5) << ',' << percentil(todas, 0.99)
+             << ',' << percentil(todas, 0.999) << ','
+             << (todas.empty() ? 0 : todas.back()) << endl;
+    }
+}
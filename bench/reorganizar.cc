@@ -0,0 +1,107 @@
+/** @file
+ * Benchmark de Sala::reorganizar.
+ *
+ * Compara la reescritura a partir del inventario de la sala con la
+ * implementación anterior, que ordenaba la estantería entera (como @c
+ * std::string) con std::sort.
+ *
+ * Uso: <tt>bench/reorganizar.exe [filas columnas productos repeticiones]</tt>
+ */
+
+#include "Catalogo.hh"
+#include "Sala.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+/// Comparador de la implementación anterior (los nulos van al final).
+static bool comp_IdProducto(const IdProducto &a, const IdProducto &b) {
+    return (not a.empty()) and (b.empty() or (a < b));
+}
+
+/// Milisegundos transcurridos desde @c inicio.
+static double ms_desde(chrono::steady_clock::time_point inicio) {
+    chrono::duration<double, milli> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+/// Mediana de un vector de tiempos (lo reordena).
+static double mediana(vector<double> &t) {
+    sort(t.begin(), t.end());
+    return t[t.size() / 2];
+}
+
+int main(int argc, char *argv[]) {
+    int filas = 1000, columnas = 1000, num_productos = 1000, reps = 5;
+    if (argc == 5) {
+        filas = atoi(argv[1]);
+        columnas = atoi(argv[2]);
+        num_productos = atoi(argv[3]);
+        reps = atoi(argv[4]);
+    }
+
+    // Productos con identificadores pseudoaleatorios
+    mt19937 rng(42);
+    Catalogo catalogo;
+    vector<Producto> codigos;
+    for (int i = 0; i < num_productos; ++i) {
+        ostringstream id;
+        id << char('A' + rng() % 26) << char('A' + rng() % 26) << i;
+        codigos.push_back(catalogo.alta(id.str()));
+    }
+
+    // Sala llena al 90%, fragmentada al quitar ítems al azar
+    Sala sala(filas, columnas);
+    int tamano = filas * columnas;
+    while (sala.poner_items(codigos[rng() % num_productos], 1 + rng() % 16) ==
+           0) {}
+    for (int i = 0; i < tamano / 10 / 8; ++i) {
+        sala.quitar_items(codigos[rng() % num_productos], 1 + rng() % 16);
+    }
+
+    // La misma estantería, como la guardaba la implementación anterior
+    Estanteria base;
+    for (int f = filas; f > 0; --f) {
+        for (int c = 1; c <= columnas; ++c) {
+            Producto p = sala.consultar_pos(f, c);
+            base.push_back(p);
+        }
+    }
+    vector<IdProducto> cadenas(base.size());
+    for (int i = 0; i < base.size(); ++i) {
+        if (base[i] != NINGUN_PRODUCTO) cadenas[i] = catalogo.nombre(base[i]);
+    }
+
+    vector<double> t_sort, t_frio, t_caliente;
+    for (int r = 0; r < reps; ++r) {
+        vector<IdProducto> copia = cadenas;
+        chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+        sort(copia.begin(), copia.end(), comp_IdProducto);
+        t_sort.push_back(ms_desde(inicio));
+
+        Sala s = sala; // Copia: el orden de productos no está calculado
+        inicio = chrono::steady_clock::now();
+        s.reorganizar(catalogo);
+        t_frio.push_back(ms_desde(inicio));
+
+        inicio = chrono::steady_clock::now();
+        s.reorganizar(catalogo);
+        t_caliente.push_back(ms_desde(inicio));
+    }
+
+    cout << "reorganizar " << filas << 'x' << columnas << ", "
+         << num_productos << " productos, mediana de " << reps
+         << " repeticiones" << endl;
+    cout << "  std::sort (cadenas):          " << mediana(t_sort) << " ms"
+         << endl;
+    cout << "  Sala::reorganizar:            " << mediana(t_frio) << " ms"
+         << endl;
+    cout << "  Sala::reorganizar (repetida): " << mediana(t_caliente) << " ms"
+         << endl;
+}
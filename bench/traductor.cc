@@ -0,0 +1,149 @@
+/** @file
+ * Traductor entre el protocolo de texto y el binario (ver Protocolo.hh),
+ * para probar <tt>program.exe --binario</tt>.
+ *
+ * - <tt>bench/traductor.exe --binario < entrada.inp > entrada.bin</tt>:
+ *   traduce una entrada de texto a la entrada de
+ *   <tt>program.exe --binario</tt> (la estructura del almacén tal cual, un
+ *   salto de línea y una trama por instrucción, hasta @c fin).
+ * - <tt>bench/traductor.exe --texto entrada.inp < salida.bin</tt>: traduce
+ *   las respuestas binarias a las instrucciones de @c entrada.inp (en
+ *   texto) a la salida que habría escrito @c program.exe, con el eco de cada
+ *   instrucción y los listados estructurados (ver listado_estructurado())
+ *   convertidos en texto.
+ *
+ * Así, <tt>bench/traductor.exe --binario < entrada.inp | program.exe
+ * --binario | bench/traductor.exe --texto entrada.inp</tt> escribe lo mismo
+ * que <tt>program.exe < entrada.inp</tt>.
+ */
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#include "Lector.hh"
+#include "Protocolo.hh"
+#include "Salida.hh"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+/** Lee la entrada de texto @c fichero (o la entrada estándar, si es NULL) y
+ * salta la estructura del almacén.
+ *
+ * @param[out] datos
+ * Contenido de la entrada.
+ *
+ * @returns
+ * La longitud de la estructura del almacén en @c datos, o -1 si no se ha
+ * podido leer la entrada.
+ */
+static int leer_entrada(const char *fichero, string &datos) {
+    ostringstream contenido;
+    if (fichero) {
+        ifstream f(fichero, ios::binary);
+        if (not f) return -1;
+        contenido << f.rdbuf();
+    } else {
+        contenido << cin.rdbuf();
+    }
+    datos = contenido.str();
+    Lector lector(datos.data(), datos.size());
+    Almacen almacen;
+    almacen.leer(lector);
+    return lector.posicion();
+}
+
+/// Traduce la entrada estándar (texto) a binario.
+static int a_binario() {
+    string datos;
+    int estructura = leer_entrada(NULL, datos);
+    Salida salida(STDOUT_FILENO, 1 << 20);
+    ostream os(&salida);
+    os.write(datos.data(), estructura) << '\n';
+    Lector lector(datos.data() + estructura, datos.size() - estructura);
+    CodificadorBinario codificador;
+    Comando comando;
+    while (leer_comando(lector, comando)) {
+        codificador.escribir_comando(os, comando);
+        if (comando.tipo == FIN) break;
+    }
+    os.flush();
+    return 0;
+}
+
+/// Escribe un listado como el de la instrucción @c tipo en texto.
+static void escribir_listado(ostream &os, TipoComando tipo,
+                             const Listado &listado) {
+    if (not listado_estructurado(tipo)) {
+        os << listado.texto;
+        return;
+    }
+    if (tipo == ESCRIBIR) {
+        int elementos = 0;
+        for (const pair<IdProducto, int> &p : listado.productos) {
+            elementos += p.second;
+        }
+        for (int i = 0; i < listado.estanteria.size(); ++i) {
+            if (i % listado.columnas == 0) os << ' ';
+            const IdProducto &producto = listado.estanteria[i];
+            os << ' ' << (producto.empty() ? "NULL" : producto);
+            if ((i + 1) % listado.columnas == 0) os << '\n';
+        }
+        os << "  " << elementos << '\n';
+    }
+    for (const pair<IdProducto, int> &p : listado.productos) {
+        os << "  " << p.first << ' ' << p.second << '\n';
+    }
+}
+
+/** Traduce las respuestas de la entrada estándar (binario) a texto, con el
+ * eco de las instrucciones de @c fichero.
+ */
+static int a_texto(const char *fichero) {
+    string datos;
+    int estructura = leer_entrada(fichero, datos);
+    if (estructura < 0) {
+        cerr << "No se ha podido abrir " << fichero << endl;
+        return 1;
+    }
+    Lector instrucciones(datos.data() + estructura, datos.size() - estructura);
+    Lector respuestas(STDIN_FILENO);
+    Salida salida(STDOUT_FILENO, 1 << 20);
+    ostream os(&salida);
+    DecodificadorBinario decodificador;
+    Comando comando;
+    Resultado resultado;
+    TipoComando tipo;
+    Listado listado;
+    while (decodificador.leer_respuesta(respuestas, tipo, resultado,
+                                        listado)) {
+        if (tipo == FIN) {
+            os << "fin" << '\n';
+            os.flush();
+            return 0;
+        }
+        if (not leer_comando(instrucciones, comando) or comando.tipo != tipo) {
+            os.flush();
+            cerr << "La respuesta no corresponde a la instrucción" << endl;
+            return 1;
+        }
+        escribir_eco(os, comando);
+        escribir_listado(os, tipo, listado);
+        escribir_resultado(os, comando, resultado);
+    }
+    os.flush();
+    cerr << "Respuesta mal formada o sin fin" << endl;
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 2 and strcmp(argv[1], "--binario") == 0) return a_binario();
+    if (argc == 3 and strcmp(argv[1], "--texto") == 0) return a_texto(argv[2]);
+    cerr << "Uso: " << argv[0] << " --binario < entrada.inp > entrada.bin\n"
+         << "     " << argv[0] << " --texto entrada.inp < salida.bin" << endl;
+    return 1;
+}
@@ -0,0 +1,101 @@
+/** @file
+ * Benchmark de Tuberia.
+ *
+ * Procesa una entrada (p.ej. generada con bench/generar.exe) de principio a
+ * fin, leyéndola del fichero y escribiendo las respuestas en @c /dev/null,
+ * de forma secuencial (como main()) y con una Tuberia, y escribe en CSV las
+ * instrucciones por segundo de cada modo.
+ *
+ * Uso: <tt>bench/tuberia.exe entrada.inp [repeticiones]</tt>
+ */
+
+#include "Almacen.hh"
+#include "Comando.hh"
+#include "Estadisticas.hh"
+#include "Lector.hh"
+#include "Salida.hh"
+#include "Tuberia.hh"
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+/** Procesa la entrada @c fichero, con una Tuberia si @c tuberia.
+ *
+ * @param[out] instrucciones
+ * Número de instrucciones procesadas.
+ *
+ * @returns
+ * Tiempo en milisegundos (sin contar la lectura del almacén), o -1 si no se
+ * ha podido abrir el fichero.
+ */
+static double procesar(const char *fichero, bool tuberia,
+                       long long &instrucciones) {
+    int fd = open(fichero, O_RDONLY);
+    int nulo = open("/dev/null", O_WRONLY);
+    if (fd < 0 or nulo < 0) return -1;
+    double ms;
+    {
+        Lector lector(fd);
+        Salida salida(nulo, 1 << 20);
+        ostream os(&salida);
+        Almacen almacen;
+        almacen.leer(lector);
+        Estadisticas estadisticas(false);
+        chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+        if (tuberia) {
+            instrucciones = Tuberia(almacen, lector, os, 1024, 0, false)
+                                .ejecutar(estadisticas);
+        } else {
+            instrucciones = 0;
+            Comando comando;
+            Resultado resultado;
+            while (leer_comando(lector, comando) and comando.tipo != FIN) {
+                escribir_eco(os, comando);
+                if (comando.tipo == ESTADISTICAS) {
+                    estadisticas.escribir(os, almacen.consultar_trabajo());
+                } else if (comando.tipo == PUNTO_CONTROL) {
+                    resultado.valor = 0;
+                } else {
+                    ejecutar(almacen, comando, resultado, os);
+                }
+                estadisticas.contar(comando.tipo);
+                escribir_resultado(os, comando, resultado);
+                ++instrucciones;
+            }
+        }
+        os.flush();
+        chrono::duration<double, milli> d =
+            chrono::steady_clock::now() - inicio;
+        ms = d.count();
+    }
+    close(fd);
+    close(nulo);
+    return ms;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        cerr << "Uso: " << argv[0] << " entrada.inp [repeticiones]" << endl;
+        return 1;
+    }
+    int repeticiones = argc > 2 ? atoi(argv[2]) : 3;
+
+    cout << "modo,repeticion,instrucciones,ms,instrucciones_por_s" << endl;
+    for (int r = 0; r < repeticiones; ++r) {
+        for (int tuberia = 0; tuberia < 2; ++tuberia) {
+            long long n;
+            double ms = procesar(argv[1], tuberia, n);
+            if (ms < 0) {
+                cerr << "No se ha podido abrir " << argv[1] << endl;
+                return 1;
+            }
+            cout << (tuberia ? "tuberia" : "secuencial") << ',' << r << ','
+                 << n << ',' << ms << ',' << 1000 * n / ms << endl;
+        }
+    }
+}
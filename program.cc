@@ -1,144 +1,330 @@
 /// @file
 
 #include "Almacen.hh"
+#include "Comando.hh"
+#include "Diario.hh"
+#include "Estadisticas.hh"
+#include "Lector.hh"
+#include "Paralelo.hh"
+#include "Protocolo.hh"
 #include "Sala.hh"
+#include "Salida.hh"
+#include "Servidor.hh"
+#include "Tuberia.hh"
 #include "aux.hh"
 #ifndef NO_DIAGRAM
+#    include <algorithm> // std::max
+#    include <chrono>
+#    include <cstdlib>
+#    include <cstring>
 #    include <iostream>
+#    include <memory>
+#    include <sstream>
+#    include <unistd.h> // isatty
 #    include <utility>
 #    include <vector>
 #endif // NO_DIAGRAM
 
 using namespace std;
 
+/** Ejecuta una instrucción como main(): con el diario y las estadísticas.
+ *
+ * @param os
+ * Stream en el que se escribe el listado de la instrucción (si tiene).
+ *
+ * @param diario
+ * Diario (o NULL): se usa en @c punto_control y tras un @c cargar. Como el
+ * diario no anota los @c cargar, uno sólo tiene éxito si se puede hacer un
+ * punto de control justo después; si no, el almacén vuelve a su estado
+ * anterior (el que refleja el diario) y la instrucción falla.
+ *
+ * @pre
+ * @c comando no es @ref FIN.
+ */
+static void procesar(Almacen &almacen, const Comando &comando,
+                     Resultado &resultado, ostream &os, Diario *diario,
+                     Estadisticas &estadisticas, bool medir) {
+    unique_ptr<Almacen> anterior;
+    if (diario and comando.tipo == CARGAR) anterior.reset(new Almacen(almacen));
+    if (comando.tipo == ESTADISTICAS) {
+        estadisticas.contar(comando.tipo);
+        estadisticas.escribir(os, almacen.consultar_trabajo());
+    } else if (comando.tipo == PUNTO_CONTROL) {
+        estadisticas.contar(comando.tipo);
+        resultado.valor = diario and diario->punto_control(almacen);
+    } else if (medir) {
+        chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+        ejecutar(almacen, comando, resultado, os);
+        chrono::nanoseconds ns = chrono::steady_clock::now() - inicio;
+        estadisticas.registrar(comando.tipo, ns.count());
+    } else {
+        ejecutar(almacen, comando, resultado, os);
+        estadisticas.contar(comando.tipo);
+    }
+    if (anterior and resultado.valor == 1 and
+        not diario->punto_control(almacen)) {
+        almacen = move(*anterior);
+        resultado.valor = 0;
+    }
+}
+
 /** Punto de entrada del programa.
  *
  * main() crea el almacén y contiene el bucle de lectura de instrucciones y
- * escritura de resultados. Las operaciones en sí están definidas e
- * implementadas en las clases Almacen y Sala.
+ * escritura de resultados (ver Comando.hh). Las operaciones en sí están
+ * definidas e implementadas en las clases Almacen y Sala.
+ *
+ * La salida no se vacía en cada línea (no se usa @c endl), sino al llegar a
+ * @c fin o cuando se llena el buffer de salida (ver Salida, de 1 MiB).
+ * Opciones:
+ * - <tt>--ventana=N</tt>: vaciar la salida cada @c N instrucciones (por
+ *   defecto, 0: sólo al final).
+ * - <tt>--estadisticas</tt>: medir la latencia de cada instrucción y
+ *   escribir las estadísticas (ver Estadisticas) por la salida de error al
+ *   llegar a @c fin. Sin esta opción, la instrucción @c estadisticas sólo
+ *   muestra los contadores.
+ * - <tt>--diario=PREFIJO</tt>: recuperar el estado guardado en el diario
+ *   @c PREFIJO (ver Diario) después de leer el almacén, y anotar en él las
+ *   instrucciones que lo modifican. La instrucción @c punto_control empieza
+ *   una generación nueva del diario; tras un @c cargar también se hace un
+ *   punto de control, ya que el diario no puede reproducirlo.
+ * - <tt>--lote=N</tt>: escribir el diario cada @c N instrucciones (por
+ *   defecto, 64); en cualquier caso, se escribe antes que la salida.
+ * - <tt>--hilos=N</tt>: ejecutar las instrucciones de sala con @c N hilos
+ *   (ver EjecutorParalelo), en lotes de hasta 4096 instrucciones seguidas
+ *   (o @c N de <tt>--ventana</tt>, si es menor; la salida se vacía tras
+ *   cada lote lleno). El resto de instrucciones se ejecutan como siempre,
+ *   después de vaciar el lote. La salida no cambia.
+ * - <tt>--tuberia</tt>: leer, ejecutar y escribir las instrucciones en tres
+ *   hilos (ver Tuberia). La salida no cambia. No se puede combinar con
+ *   <tt>--diario</tt> ni con <tt>--hilos</tt>.
+ * - <tt>--servidor=RUTA</tt>: leer sólo el almacén de la entrada estándar y
+ *   atender después a clientes por el socket Unix @c RUTA (ver Servidor)
+ *   hasta recibir @c SIGINT o @c SIGTERM. Las estadísticas se escriben al
+ *   terminar. No se puede combinar con <tt>--diario</tt>, <tt>--hilos</tt>
+ *   ni <tt>--tuberia</tt>.
+ * - <tt>--binario</tt>: leer las instrucciones y escribir las respuestas
+ *   con el protocolo binario (ver Protocolo.hh), sin eco. La estructura del
+ *   almacén se sigue leyendo en texto. Sólo se puede combinar con
+ *   <tt>--diario</tt>, <tt>--lote</tt>, <tt>--ventana</tt> y
+ *   <tt>--estadisticas</tt>.
+ *
+ * Si la entrada es un terminal, la salida se vacía antes de leer cada
+ * instrucción, de forma que el uso interactivo no cambia (y no se usan
+ * hilos, que retrasarían las respuestas hasta el final del lote o las
+ * escribirían desde otro hilo).
+ *
+ * La entrada se lee con un Lector (por bloques, sin @c iostream).
  */
-int main() {
-    // Crear almacén
-    Almacen almacen;
-    almacen.leer(cin);
-
-    // Procesar instrucciones
-    string inst;
-    while ((cin >> inst) and (inst != "fin")) {
-        if (inst == "poner_prod") {
-            IdProducto id_producto;
-            cin >> id_producto;
-            cout << inst << ' ' << id_producto << endl;
-            bool ok = almacen.poner_prod(id_producto);
-            if (not ok) cout << "  error" << endl;
-
-        } else if (inst == "quitar_prod") {
-            IdProducto id_producto;
-            cin >> id_producto;
-            cout << inst << ' ' << id_producto << endl;
-            bool ok = almacen.quitar_prod(id_producto);
-            if (not ok) cout << "  error" << endl;
-
-        } else if (inst == "poner_items") {
-            IdSala id_sala;
-            IdProducto id_producto;
-            int cantidad;
-            cin >> id_sala >> id_producto >> cantidad;
-            cout << inst << ' ' << id_sala << ' ' << id_producto << ' '
-                 << cantidad << endl;
-            int sobran = almacen.poner_items(id_sala, id_producto, cantidad);
-            if (sobran != -1)
-                cout << "  " << sobran << endl;
-            else
-                cout << "  error" << endl;
-
-        } else if (inst == "quitar_items") {
-            IdSala id_sala;
-            IdProducto id_producto;
-            int cantidad;
-            cin >> id_sala >> id_producto >> cantidad;
-            cout << inst << ' ' << id_sala << ' ' << id_producto << ' '
-                 << cantidad << endl;
-            int faltan = almacen.quitar_items(id_sala, id_producto, cantidad);
-            if (faltan != -1)
-                cout << "  " << faltan << endl;
-            else
-                cout << "  error" << endl;
+int main(int argc, char *argv[]) {
+    int ventana = 0;
+    bool medir = false;
+    string prefijo_diario;
+    int lote = 64;
+    int num_hilos = 1;
+    bool tuberia = false;
+    string ruta_servidor;
+    bool binario = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--ventana=", 10) == 0) {
+            ventana = atoi(argv[i] + 10);
+        } else if (strcmp(argv[i], "--estadisticas") == 0) {
+            medir = true;
+        } else if (strncmp(argv[i], "--diario=", 9) == 0) {
+            prefijo_diario = argv[i] + 9;
+        } else if (strncmp(argv[i], "--lote=", 7) == 0) {
+            lote = max(1, atoi(argv[i] + 7));
+        } else if (strncmp(argv[i], "--hilos=", 8) == 0) {
+            num_hilos = max(1, atoi(argv[i] + 8));
+        } else if (strcmp(argv[i], "--tuberia") == 0) {
+            tuberia = true;
+        } else if (strncmp(argv[i], "--servidor=", 11) == 0) {
+            ruta_servidor = argv[i] + 11;
+        } else if (strcmp(argv[i], "--binario") == 0) {
+            binario = true;
+        } else {
+            cerr << "Opción desconocida: " << argv[i] << endl;
+            return 1;
+        }
+    }
+    if (tuberia and (not prefijo_diario.empty() or num_hilos > 1)) {
+        cerr << "--tuberia no se puede combinar con --diario ni --hilos"
+             << endl;
+        return 1;
+    }
+    if (not ruta_servidor.empty() and
+        (not prefijo_diario.empty() or num_hilos > 1 or tuberia)) {
+        cerr << "--servidor no se puede combinar con --diario, --hilos ni "
+                "--tuberia"
+             << endl;
+        return 1;
+    }
+    if (binario and (num_hilos > 1 or tuberia or not ruta_servidor.empty())) {
+        cerr << "--binario no se puede combinar con --hilos, --tuberia ni "
+                "--servidor"
+             << endl;
+        return 1;
+    }
 
-        } else if (inst == "distribuir") {
-            IdProducto id_producto;
-            int cantidad;
-            cin >> id_producto >> cantidad;
-            cout << inst << ' ' << id_producto << ' ' << cantidad << endl;
-            int sobran = almacen.distribuir(id_producto, cantidad);
-            if (sobran != -1)
-                cout << "  " << sobran << endl;
-            else
-                cout << "  error" << endl;
+    Salida salida(STDOUT_FILENO, 1 << 20);
+    streambuf *salida_original = cout.rdbuf(&salida);
 
-        } else if (inst == "compactar") {
-            IdSala id_sala;
-            cin >> id_sala;
-            cout << inst << ' ' << id_sala << endl;
-            almacen.compactar(id_sala);
+    // Si se usa el programa interactivamente, se vacía la salida antes de
+    // esperar la siguiente instrucción (como hace cin.tie()).
+    Lector lector(STDIN_FILENO);
+    if (isatty(STDIN_FILENO) and not binario) lector.ligar(&cout);
 
-        } else if (inst == "reorganizar") {
-            IdSala id_sala;
-            cin >> id_sala;
-            cout << inst << ' ' << id_sala << endl;
-            almacen.reorganizar(id_sala);
+    // Crear almacén
+    Almacen almacen;
+    almacen.leer(lector);
 
-        } else if (inst == "redimensionar") {
-            IdSala id_sala;
-            int f, c;
-            cin >> id_sala >> f >> c;
-            cout << inst << ' ' << id_sala << ' ' << f << ' ' << c << endl;
-            bool ok = almacen.redimensionar(id_sala, f, c);
-            if (not ok) cout << "  error" << endl;
+    // En modo servidor las instrucciones llegan por el socket
+    if (not ruta_servidor.empty()) {
+        cout.rdbuf(salida_original);
+        Servidor servidor(almacen, ruta_servidor, medir);
+        if (not servidor.escuchar()) {
+            cerr << "No se ha podido crear el socket " << ruta_servidor
+                 << endl;
+            return 1;
+        }
+        Estadisticas estadisticas(medir);
+        servidor.ejecutar(estadisticas);
+        if (medir) {
+            cerr << "estadisticas" << '\n';
+            estadisticas.escribir(cerr, almacen.consultar_trabajo());
+        }
+        return 0;
+    }
 
-        } else if (inst == "inventario") {
-            cout << inst << endl;
-            almacen.inventario(cout);
-        } else if (inst == "escribir") {
-            IdSala id_sala;
-            cin >> id_sala;
-            cout << inst << ' ' << id_sala << endl;
-            almacen.escribir(id_sala, cout);
+    // Recuperar el diario. Se liga a la salida para que ninguna respuesta se
+    // escriba antes que la instrucción que la produce.
+    unique_ptr<Diario> diario;
+    if (not prefijo_diario.empty()) {
+        diario.reset(new Diario(prefijo_diario, lote));
+        if (diario->recuperar(almacen) < 0) {
+            cerr << "No se ha podido recuperar el diario " << prefijo_diario
+                 << endl;
+            cout.rdbuf(salida_original);
+            return 1;
+        }
+        salida.ligar(&diario->flujo());
+    }
 
-        } else if (inst == "consultar_pos") {
-            IdSala id_sala;
-            int f, c;
-            cin >> id_sala >> f >> c;
-            cout << inst << ' ' << id_sala << ' ' << f << ' ' << c << endl;
-            IdProducto id_producto = almacen.consultar_pos(id_sala, f, c);
-            cout << "  " << id_producto << endl;
+    // Las instrucciones de sala seguidas se ejecutan en paralelo
+    unique_ptr<EjecutorParalelo> paralelo;
+    if (num_hilos > 1 and not isatty(STDIN_FILENO)) {
+        int capacidad = ventana > 0 ? min(ventana, 4096) : 4096;
+        paralelo.reset(
+            new EjecutorParalelo(almacen, num_hilos, capacidad, medir));
+    }
 
-        } else if (inst == "consultar_prod") {
-            IdProducto id_producto;
-            cin >> id_producto;
-            cout << inst << ' ' << id_producto << endl;
-            int num = almacen.consultar_prod(id_producto);
-            if (num == -1)
-                cout << "  error" << endl;
-            else
-                cout << "  " << num << endl;
-        } else {
-            cout << inst << endl;
-            cout << "  error" << endl;
+    // Procesar instrucciones
+    Comando comando;
+    Resultado resultado;
+    Estadisticas estadisticas(medir);
+    int procesadas = 0;
+    if (binario) {
+        // La estructura acaba con un salto de línea; después, las tramas
+        Token separador;
+        lector.leer_bytes(separador, 1);
+        DecodificadorBinario decodificador;
+        CodificadorBinario codificador;
+        ostringstream listado;
+        while (decodificador.leer_comando(lector, comando) and
+               comando.tipo != FIN) {
+            if (diario) diario->anotar(comando);
+            if (listado_estructurado(comando.tipo)) {
+                // escribir e inventario no modifican nada: no se ejecutan
+                // en texto, se escriben en binario directamente
+                if (medir) {
+                    chrono::steady_clock::time_point inicio =
+                        chrono::steady_clock::now();
+                    codificador.escribir_listado(cout, comando, almacen);
+                    chrono::nanoseconds ns =
+                        chrono::steady_clock::now() - inicio;
+                    estadisticas.registrar(comando.tipo, ns.count());
+                } else {
+                    codificador.escribir_listado(cout, comando, almacen);
+                    estadisticas.contar(comando.tipo);
+                }
+                if (ventana > 0 and ++procesadas % ventana == 0) cout.flush();
+                continue;
+            }
+            procesar(almacen, comando, resultado, listado, diario.get(),
+                     estadisticas, medir);
+            // Casi ninguna instrucción escribe un listado: no se copia el
+            // stream si está vacío.
+            if (listado.tellp() > 0) {
+                codificador.escribir_respuesta(cout, comando.tipo, resultado,
+                                               listado.str());
+                listado.str(string());
+            } else {
+                codificador.escribir_respuesta(cout, comando.tipo, resultado,
+                                               string());
+            }
+            if (ventana > 0 and ++procesadas % ventana == 0) cout.flush();
+        }
+        if (diario) diario->confirmar();
+        codificador.escribir_respuesta(cout, FIN, resultado, string());
+        cout.flush();
+        salida.ligar(NULL);
+        if (medir) {
+            cerr << "estadisticas" << '\n';
+            estadisticas.escribir(cerr, almacen.consultar_trabajo());
         }
+        cout.rdbuf(salida_original);
+        return 0;
     }
+    if (tuberia and isatty(STDIN_FILENO)) tuberia = false;
+    if (tuberia) {
+        // La tubería procesa todas las instrucciones: el bucle no se ejecuta
+        Tuberia(almacen, lector, cout, 1024, ventana, medir)
+            .ejecutar(estadisticas);
+    }
+    while (not tuberia and leer_comando(lector, comando) and
+           comando.tipo != FIN) {
+        if (diario) diario->anotar(comando);
+        if (paralelo and EjecutorParalelo::admite(comando.tipo)) {
+            paralelo->anadir(comando);
+            if (paralelo->lleno()) {
+                paralelo->vaciar(cout, estadisticas);
+                if (ventana > 0) cout.flush();
+            }
+            continue;
+        }
+        if (paralelo) paralelo->vaciar(cout, estadisticas);
+        escribir_eco(cout, comando);
+        procesar(almacen, comando, resultado, cout, diario.get(),
+                 estadisticas, medir);
+        escribir_resultado(cout, comando, resultado);
+        if (ventana > 0 and ++procesadas % ventana == 0) cout.flush();
+    }
+    if (paralelo) paralelo->vaciar(cout, estadisticas);
+    if (diario) diario->confirmar();
     cout << "fin" << endl;
+    salida.ligar(NULL);
+    if (medir) {
+        cerr << "estadisticas" << '\n';
+        estadisticas.escribir(cerr, almacen.consultar_trabajo());
+    }
+    cout.rdbuf(salida_original);
 }
 
 /** @mainpage
  *
  * @section diseno Diseño del programa
  *
- * El programa está dividido en dos clases (Almacen y Sala) y dos estructuras
- * auxiliares definidas como @em typedefs (@ref IdProducto e @ref Inventario).
+ * El programa está dividido en tres clases (Almacen, Sala y Catalogo) y
+ * varias estructuras auxiliares definidas como @em typedefs (como @ref
+ * IdProducto o @ref Producto).
  *
  * El usuario deberá usar Almacen que, cuando sea conveniente, llamará a una
- * Sala, que guarda internamente. La comunicación con algunos métodos de Almacen
+ * Sala, que guarda internamente. Las salas no guardan los identificadores de
+ * los productos, sino los códigos que les asigna el Catalogo del almacén.
+ *
+ * El bucle principal no conoce las instrucciones: las lee como un @ref
+ * Comando, las ejecuta sobre el almacén y escribe su @ref Resultado con las
+ * funciones de Comando.hh, que usan una tabla de instrucciones. La comunicación con algunos métodos de Almacen
  * (Almacen::inventario, Almacen::leer y Almacen::escribir) se realiza mediante
  * @em streams para evitar pasar estructuras complejas de datos. Esto facilita
  * la implementación actual, ya que utilizamos la entrada/salida estándar.
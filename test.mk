@@ -3,17 +3,19 @@
 all: public-tests custom-tests
 
 PYTHON = python3.6
+# Programa a probar (p.ej. build/release/program.exe)
+PROGRAM = ./program.exe
 
-public-tests: program.exe sample.inp sample.cor
-	./program.exe < sample.inp | diff - sample.cor
+public-tests: $(PROGRAM) sample.inp sample.cor
+	$(PROGRAM) < sample.inp | diff - sample.cor
 
-custom-tests: program.exe custom.inp custom.cor
-	./program.exe < custom.inp | diff - custom.cor
+custom-tests: $(PROGRAM) custom.inp custom.cor
+	$(PROGRAM) < custom.inp | diff - custom.cor
 
 custom.inp custom.cor: testpp.py custom_tests/*
 	$(PYTHON) testpp.py -o custom custom_tests
 
 .PHONY: clean
 clean:
-	rm -vf custom.inp custom.cor
+	rm -vf custom.inp custom.cor custom.snap
 